@@ -0,0 +1,126 @@
+#include "AxisSetCache.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char axisSetCacheMagic[8] = { 'M', 'H', 'C', 'A', 'X', 'S', 'E', 'T' };
+
+// Bumped whenever the canonical axis solidification set order or the memoised state changes
+const uint32_t axisSetCacheVersion = 1;
+
+AxisSetCache::~AxisSetCache() {
+	if (data != nullptr) {
+		munmap(const_cast<char*>(data), dataSize);
+	}
+}
+
+bool AxisSetCache::load(const string& path, int sideLength, int dimensionality, uint64_t planHash, size_t keySize) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat fileStat;
+	void* mapping = MAP_FAILED;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size >= (off_t)sizeof(AxisSetCacheHeader)) {
+		mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	const AxisSetCacheHeader* mappedHeader = static_cast<const AxisSetCacheHeader*>(mapping);
+	size_t mappedRecordSize = keySize + sizeof(uint64_t);
+	bool matches = memcmp(mappedHeader->magic, axisSetCacheMagic, sizeof(axisSetCacheMagic)) == 0
+		&& mappedHeader->version == axisSetCacheVersion
+		&& mappedHeader->sideLength == sideLength
+		&& mappedHeader->dimensionality == dimensionality
+		&& mappedHeader->keySize == keySize
+		&& mappedHeader->planHash == planHash
+		&& fileStat.st_size == (off_t)(sizeof(AxisSetCacheHeader) + mappedHeader->entryCount * mappedRecordSize);
+	if (!matches) {
+		munmap(mapping, fileStat.st_size);
+		return false;
+	}
+
+	data = static_cast<const char*>(mapping);
+	dataSize = fileStat.st_size;
+	header = mappedHeader;
+	records = data + sizeof(AxisSetCacheHeader);
+	recordSize = mappedRecordSize;
+	return true;
+}
+
+bool AxisSetCache::isLoaded() {
+	return data != nullptr;
+}
+
+unsigned long AxisSetCache::getAxisSolidificationSetCount() {
+	return header->axisSolidificationSetCount;
+}
+
+bool AxisSetCache::find(const string& key, unsigned long& count) {
+	// Binary search over the sorted records
+	size_t low = 0;
+	size_t high = header->entryCount;
+	while (low < high) {
+		size_t middle = (low + high) / 2;
+		const char* record = records + middle * recordSize;
+		int comparison = memcmp(record, key.data(), header->keySize);
+		if (comparison == 0) {
+			uint64_t recordCount;
+			memcpy(&recordCount, record + header->keySize, sizeof(recordCount));
+			count = recordCount;
+			return true;
+		}
+		if (comparison < 0) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	return false;
+}
+
+void AxisSetCache::save(const string& path, int sideLength, int dimensionality, uint64_t planHash, size_t keySize,
+	unsigned long axisSolidificationSetCount, unordered_map<string, unsigned long>& counts) {
+	// std::string compares as unsigned chars, matching the memcmp() find() searches with
+	vector<const string*> keys;
+	for (auto& [key, count] : counts) {
+		keys.push_back(&key);
+	}
+	sort(keys.begin(), keys.end(), [](const string* a, const string* b) { return *a < *b; });
+
+	AxisSetCacheHeader newHeader = {};
+	memcpy(newHeader.magic, axisSetCacheMagic, sizeof(axisSetCacheMagic));
+	newHeader.version = axisSetCacheVersion;
+	newHeader.sideLength = sideLength;
+	newHeader.dimensionality = dimensionality;
+	newHeader.keySize = keySize;
+	newHeader.planHash = planHash;
+	newHeader.axisSolidificationSetCount = axisSolidificationSetCount;
+	newHeader.entryCount = keys.size();
+
+	// Written to a temporary file first so that concurrent runs never map a partially written cache
+	string temporaryPath = path + ".tmp" + to_string(getpid());
+	{
+		ofstream ofs(temporaryPath, ios::binary);
+		ofs.write(reinterpret_cast<const char*>(&newHeader), sizeof(newHeader));
+		for (const string* key : keys) {
+			uint64_t count = counts[*key];
+			ofs.write(key->data(), keySize);
+			ofs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		}
+		if (!ofs) {
+			ofs.close();
+			filesystem::remove(temporaryPath);
+			return;
+		}
+	}
+	filesystem::rename(temporaryPath, path);
+}
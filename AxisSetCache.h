@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+using std::string;
+using std::unordered_map;
+
+// Layout of the start of an axis set cache file, followed by entryCount records of keySize key bytes and a uint64_t count,
+// sorted by key
+struct AxisSetCacheHeader {
+	char magic[8];
+	uint32_t version;
+	int32_t sideLength;
+	int32_t dimensionality;
+	uint32_t keySize;
+	uint64_t planHash;
+	uint64_t axisSolidificationSetCount;
+	uint64_t entryCount;
+};
+
+/*
+* Persistent cache of the axis completion counts that Generator::countAxisCompletions() memoises, along with the total
+* number of axis solidification sets. The file is memory mapped and searched in place, so later runs of the same
+* configuration skip counting entirely, and can still place any axis solidification set directly from its rank.
+*
+* Files are identified by the configuration and a hash of the segment plan, as well as a format version (which must be
+* bumped whenever the canonical axis solidification set order or the memoised state changes). A file that doesn't match
+* is ignored, and replaced once the counts have been recalculated
+*/
+class AxisSetCache {
+	const char* data = nullptr; // Mapped file, or nullptr if not loaded
+	size_t dataSize = 0;
+	const AxisSetCacheHeader* header = nullptr;
+	const char* records = nullptr;
+	size_t recordSize = 0;
+
+public:
+	~AxisSetCache();
+
+	// Maps the cache file, returning false (and leaving the cache unloaded) if it is missing or doesn't match the
+	// configuration, plan and key size given
+	bool load(const string& path, int sideLength, int dimensionality, uint64_t planHash, size_t keySize);
+
+	bool isLoaded();
+	unsigned long getAxisSolidificationSetCount();
+
+	// Looks up the count cached for the key, returning false if there is none
+	bool find(const string& key, unsigned long& count);
+
+	// Writes a new cache file holding the counts (replacing any existing file in a single rename)
+	void save(const string& path, int sideLength, int dimensionality, uint64_t planHash, size_t keySize,
+		unsigned long axisSolidificationSetCount, unordered_map<string, unsigned long>& counts);
+};
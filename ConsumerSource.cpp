@@ -0,0 +1,64 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include "CubeRing.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using std::to_string;
+using std::this_thread::sleep_for;
+using std::chrono::milliseconds;
+
+/*
+* Minimal consumer of the cube identities the generator streams through a shared memory ring (see --stream), which
+* writes them to stdout in the same text format as 'Magic Cubes.txt', so that a stream can be checked against a run
+* written to file. Once the stream has finished and been drained, the consumer removes the ring
+*/
+int main(int argc, char* argv[]) {
+	if (argc != 2) {
+		cout << "Usage: " << argv[0] << " name" << endl;
+		return 1;
+	}
+	string name = argv[1];
+
+	// The generator only creates the ring once it starts generating
+	CubeRing ring;
+	if (!ring.open(name)) {
+		cerr << "Waiting for the cube ring '" << name << "'..." << endl;
+		while (!ring.open(name)) {
+			sleep_for(milliseconds(10));
+		}
+	}
+
+	// Records are read in place, and released once formatted
+	int sideLength = ring.getSideLength();
+	int setSize = ring.getSetSize();
+	unsigned long cubeCount = 0;
+	string text;
+	const int32_t* records;
+	for (size_t count = ring.acquire(records); count > 0; count = ring.acquire(records)) {
+		for (size_t record = 0; record < count; ++record) {
+			const int32_t* cube = records + record * setSize;
+			for (int position = 0; position < setSize; ++position) {
+				text += to_string(cube[position]);
+				text += '\t';
+
+				// Ends a line after every full x axis row, and again after every full layer of each further axis
+				for (int scale = sideLength; scale <= setSize && (position + 1) % scale == 0; scale *= sideLength) {
+					text += '\n';
+				}
+			}
+		}
+		ring.release(count);
+		cubeCount += count;
+		cout << text;
+		text.clear();
+	}
+	ring.close();
+	CubeRing::remove(name);
+	cerr << "Cubes received: " << cubeCount << endl;
+	return 0;
+}
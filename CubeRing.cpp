@@ -0,0 +1,211 @@
+#include "CubeRing.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char cubeRingMagic[8] = { 'M', 'H', 'C', 'R', 'I', 'N', 'G', '\0' };
+
+// Bumped whenever the header layout or the record format changes
+const uint32_t cubeRingVersion = 1;
+
+// Records start on their own cache line, after the header
+const size_t cubeRingRecordOffset = (sizeof(CubeRingHeader) + 63) / 64 * 64;
+
+string getSharedMemoryName(const string& name) {
+	return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+CubeRing::~CubeRing() {
+	close();
+}
+
+void CubeRing::wait(atomic<uint32_t>& sequence, uint32_t value) {
+	// The futex is shared between processes, so it can't be a private one
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sequence), FUTEX_WAIT, value, nullptr, nullptr, 0);
+}
+
+void CubeRing::wake(atomic<uint32_t>& sequence) {
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&sequence), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+bool CubeRing::create(const string& name, int sideLength, int dimensionality, size_t capacityBytes) {
+	close();
+	string sharedMemoryName = getSharedMemoryName(name);
+	shm_unlink(sharedMemoryName.c_str());
+	int fd = shm_open(sharedMemoryName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0) return false;
+
+	uint32_t recordSize = 1;
+	for (int i = 0; i < dimensionality; ++i) {
+		recordSize *= sideLength;
+	}
+	recordSize *= sizeof(int32_t);
+	uint64_t capacity = bit_floor(max<size_t>(capacityBytes / recordSize, 1));
+	size_t size = cubeRingRecordOffset + capacity * recordSize;
+	void* mapping = MAP_FAILED;
+	if (ftruncate(fd, size) == 0) {
+		mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		shm_unlink(sharedMemoryName.c_str());
+		return false;
+	}
+
+	// The object starts out zeroed, so only the fixed fields need filling in, with the magic last so that a consumer
+	// never sees a partial header
+	header = static_cast<CubeRingHeader*>(mapping);
+	mappedSize = size;
+	records = static_cast<char*>(mapping) + cubeRingRecordOffset;
+	header->version = cubeRingVersion;
+	header->sideLength = sideLength;
+	header->dimensionality = dimensionality;
+	header->recordSize = recordSize;
+	header->capacity = capacity;
+	header->recordOffset = cubeRingRecordOffset;
+	atomic_thread_fence(memory_order_release);
+	memcpy(header->magic, cubeRingMagic, sizeof(cubeRingMagic));
+	return true;
+}
+
+void CubeRing::publish(const char* data, size_t size) {
+	if (header == nullptr) return;
+
+	uint64_t recordCount = size / header->recordSize;
+	uint64_t head = header->head.load(memory_order_relaxed);
+	while (recordCount > 0) {
+		// Waits for the consumer to free up space, rechecking after flagging itself as waiting so that a release made
+		// in between isn't missed
+		uint64_t tail = header->tail.load(memory_order_acquire);
+		while (head - tail == header->capacity) {
+			uint32_t sequence = header->tailSequence.load();
+			header->producerWaiting.store(1);
+			tail = header->tail.load();
+			if (head - tail == header->capacity) {
+				wait(header->tailSequence, sequence);
+				tail = header->tail.load();
+			}
+		}
+
+		// Copies as many records as fit before either the consumer's cursor or the end of the ring
+		uint64_t slot = head & (header->capacity - 1);
+		uint64_t count = min({ recordCount, header->capacity - (head - tail), header->capacity - slot });
+		memcpy(records + slot * header->recordSize, data, count * header->recordSize);
+		data += count * header->recordSize;
+		recordCount -= count;
+		head += count;
+		header->head.store(head);
+		header->headSequence.fetch_add(1);
+		if (header->consumerWaiting.exchange(0) != 0) {
+			wake(header->headSequence);
+		}
+	}
+}
+
+void CubeRing::finish() {
+	if (header == nullptr) return;
+
+	header->finished.store(1);
+	header->headSequence.fetch_add(1);
+	wake(header->headSequence);
+}
+
+bool CubeRing::open(const string& name) {
+	close();
+	int fd = shm_open(getSharedMemoryName(name).c_str(), O_RDWR, 0);
+	if (fd < 0) return false;
+
+	struct stat objectStat;
+	void* mapping = MAP_FAILED;
+	if (fstat(fd, &objectStat) == 0 && objectStat.st_size >= (off_t)cubeRingRecordOffset) {
+		mapping = mmap(nullptr, objectStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	::close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	CubeRingHeader* mappedHeader = static_cast<CubeRingHeader*>(mapping);
+	bool matches = memcmp(mappedHeader->magic, cubeRingMagic, sizeof(cubeRingMagic)) == 0;
+	atomic_thread_fence(memory_order_acquire);
+	matches = matches && mappedHeader->version == cubeRingVersion && mappedHeader->recordOffset == cubeRingRecordOffset
+		&& (size_t)objectStat.st_size >= cubeRingRecordOffset + mappedHeader->capacity * mappedHeader->recordSize;
+	if (!matches) {
+		munmap(mapping, objectStat.st_size);
+		return false;
+	}
+
+	header = mappedHeader;
+	mappedSize = objectStat.st_size;
+	records = static_cast<char*>(mapping) + cubeRingRecordOffset;
+	return true;
+}
+
+size_t CubeRing::acquire(const int32_t*& acquiredRecords) {
+	if (header == nullptr) return 0;
+
+	// Waits for the producer to publish, in the same way as publish() waits for space
+	uint64_t tail = header->tail.load(memory_order_relaxed);
+	uint64_t head = header->head.load(memory_order_acquire);
+	while (head == tail) {
+		if (header->finished.load() != 0) {
+			// Records published just before finishing are still to be drained
+			head = header->head.load();
+			if (head == tail) return 0;
+			break;
+		}
+		uint32_t sequence = header->headSequence.load();
+		header->consumerWaiting.store(1);
+		head = header->head.load();
+		if (head == tail && header->finished.load() == 0) {
+			wait(header->headSequence, sequence);
+			head = header->head.load();
+		}
+	}
+
+	uint64_t slot = tail & (header->capacity - 1);
+	acquiredRecords = reinterpret_cast<const int32_t*>(records + slot * header->recordSize);
+	return min(head - tail, header->capacity - slot);
+}
+
+void CubeRing::release(size_t count) {
+	if (header == nullptr) return;
+
+	header->tail.store(header->tail.load(memory_order_relaxed) + count);
+	header->tailSequence.fetch_add(1);
+	if (header->producerWaiting.exchange(0) != 0) {
+		wake(header->tailSequence);
+	}
+}
+
+int CubeRing::getSideLength() {
+	return header->sideLength;
+}
+
+int CubeRing::getDimensionality() {
+	return header->dimensionality;
+}
+
+int CubeRing::getSetSize() {
+	return header->recordSize / sizeof(int32_t);
+}
+
+void CubeRing::close() {
+	if (header != nullptr) {
+		munmap(header, mappedSize);
+		header = nullptr;
+		records = nullptr;
+		mappedSize = 0;
+	}
+}
+
+void CubeRing::remove(const string& name) {
+	shm_unlink(getSharedMemoryName(name).c_str());
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+using std::string;
+using std::atomic;
+
+// Layout of the start of a cube ring's shared memory object, followed (at recordOffset) by capacity records of
+// recordSize bytes. Each record is a cube identity as setSize int32_t values in print order (the x axis fastest)
+struct CubeRingHeader {
+	char magic[8];
+	uint32_t version;
+	int32_t sideLength;
+	int32_t dimensionality;
+	uint32_t recordSize;
+	uint64_t capacity; // Power of two
+	uint64_t recordOffset;
+
+	// Records published by the producer, and records released by the consumer. Each side only writes its own cursor, and
+	// bumps its sequence number whenever the cursor moves (or the stream finishes), which the other side waits on as a
+	// futex once the ring is full (or empty). The waiting flags spare the other side the wake call when nobody waits
+	alignas(64) atomic<uint64_t> head;
+	atomic<uint32_t> headSequence;
+	atomic<uint32_t> consumerWaiting;
+	atomic<uint32_t> finished; // Set by the producer once every record has been published
+	alignas(64) atomic<uint64_t> tail;
+	atomic<uint32_t> tailSequence;
+	atomic<uint32_t> producerWaiting;
+};
+
+/*
+* Single producer, single consumer ring of binary cube records in POSIX shared memory, through which the generator
+* streams cube identities straight to an analysis process (see Generator::setStreamName()), without formatting them or
+* touching the filesystem.
+*
+* This class is also the client library: a consumer open()s the ring by name, and acquire()s runs of records, which
+* it reads in place within the mapping (no copies) before release()ing them back to the producer. Either side blocks on
+* a futex, rather than spinning, while the ring is empty (or full). The shared memory object is left in place once the
+* stream finishes, so that a consumer attaching late can still drain it. The consumer owns it from then on, and removes
+* it through remove() once drained (as magicHyperCubeConsumer does). A ring nobody drained is replaced by the next
+* producer of the same name
+*/
+class CubeRing {
+	CubeRingHeader* header = nullptr; // Mapped object, or nullptr if not open
+	size_t mappedSize = 0;
+	char* records = nullptr;
+
+	// Waits (if the sequence number is still sequence) for the other side to bump it
+	static void wait(atomic<uint32_t>& sequence, uint32_t value);
+	static void wake(atomic<uint32_t>& sequence);
+
+public:
+	~CubeRing();
+
+	// Creates the ring as a producer (replacing any existing ring of the same name), holding up to capacityBytes of
+	// records. Names are POSIX shared memory names, with the leading slash optional
+	bool create(const string& name, int sideLength, int dimensionality, size_t capacityBytes);
+
+	// Publishes the records (a whole number of them), blocking while the ring is full
+	void publish(const char* data, size_t size);
+
+	// Marks the end of the stream, waking the consumer
+	void finish();
+
+	// Opens an existing ring as its consumer, returning false if there is no such ring or it isn't a cube ring of this
+	// version
+	bool open(const string& name);
+
+	// Waits for records to be published, returning the number available in a single run (at least 1, or 0 once the
+	// stream has finished and been drained), and pointing records at the first. The records stay in place until released
+	size_t acquire(const int32_t*& records);
+
+	// Hands the first count records acquired back to the producer
+	void release(size_t count);
+
+	int getSideLength();
+	int getDimensionality();
+	int getSetSize();
+
+	// Unmaps the ring
+	void close();
+
+	// Removes the named ring's shared memory object
+	static void remove(const string& name);
+};
@@ -0,0 +1,213 @@
+#include "FrontierFile.h"
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char frontierMagic[8] = { 'M', 'H', 'C', 'F', 'R', 'N', 'T', '\0' };
+
+// Bumped whenever the header layout or the frame format changes
+const uint32_t frontierVersion = 1;
+
+// Frames start on their own cache line, after the header, as do the chunk tables after them
+const uint64_t frontierFrameOffset = (sizeof(FrontierHeader) + 63) / 64 * 64;
+
+uint64_t alignToCacheLine(uint64_t offset) {
+	return (offset + 63) / 64 * 64;
+}
+
+FrontierFile::~FrontierFile() {
+	close();
+}
+
+bool FrontierFile::create(const string& _path, int sideLength, int dimensionality, uint64_t planHash, int depth,
+	uint32_t frameSize, uint32_t framesPerChunk) {
+	path = _path;
+	temporaryPath = path + ".tmp" + to_string(getpid());
+	if (!writer.open(temporaryPath)) return false;
+
+	buildHeader.version = frontierVersion;
+	buildHeader.sideLength = sideLength;
+	buildHeader.dimensionality = dimensionality;
+	buildHeader.depth = depth;
+	buildHeader.frameSize = frameSize;
+	buildHeader.framesPerChunk = framesPerChunk;
+	buildHeader.planHash = planHash;
+	buildHeader.frameCount = 0;
+	buildHeader.frameOffset = frontierFrameOffset;
+
+	// The header is only filled in once the file is complete
+	writer.getBuffer().append(frontierFrameOffset, '\0');
+	return true;
+}
+
+void FrontierFile::addFrame(const void* frame) {
+	writer.getBuffer().append(static_cast<const char*>(frame), buildHeader.frameSize);
+	++buildHeader.frameCount;
+	writer.flushIfFull();
+}
+
+bool FrontierFile::finish() {
+	writer.close();
+	if (writer.hasFailed()) {
+		filesystem::remove(temporaryPath);
+		return false;
+	}
+	buildHeader.chunkCount = (buildHeader.frameCount + buildHeader.framesPerChunk - 1) / buildHeader.framesPerChunk;
+	buildHeader.statusOffset = alignToCacheLine(frontierFrameOffset + buildHeader.frameCount * buildHeader.frameSize);
+	buildHeader.countOffset = alignToCacheLine(buildHeader.statusOffset + buildHeader.chunkCount);
+	memcpy(buildHeader.magic, frontierMagic, sizeof(frontierMagic));
+
+	// Extending the file zeroes the chunk tables, leaving every chunk unclaimed
+	int buildFd = ::open(temporaryPath.c_str(), O_RDWR);
+	bool written = buildFd >= 0
+		&& ftruncate(buildFd, buildHeader.countOffset + buildHeader.chunkCount * sizeof(uint64_t)) == 0
+		&& pwrite(buildFd, &buildHeader, sizeof(buildHeader), 0) == sizeof(buildHeader);
+	if (buildFd >= 0) ::close(buildFd);
+	if (!written) {
+		filesystem::remove(temporaryPath);
+		return false;
+	}
+	filesystem::rename(temporaryPath, path);
+	return true;
+}
+
+bool FrontierFile::open(const string& path, int sideLength, int dimensionality, uint64_t planHash) {
+	close();
+	fd = ::open(path.c_str(), O_RDWR);
+	if (fd < 0) return false;
+
+	struct stat fileStat;
+	void* mapping = MAP_FAILED;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size >= (off_t)frontierFrameOffset) {
+		mapping = mmap(nullptr, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	if (mapping == MAP_FAILED) {
+		close();
+		return false;
+	}
+
+	FrontierHeader* mappedHeader = static_cast<FrontierHeader*>(mapping);
+	bool matches = memcmp(mappedHeader->magic, frontierMagic, sizeof(frontierMagic)) == 0
+		&& mappedHeader->version == frontierVersion
+		&& mappedHeader->sideLength == sideLength
+		&& mappedHeader->dimensionality == dimensionality
+		&& mappedHeader->planHash == planHash
+		&& mappedHeader->frameOffset == frontierFrameOffset
+		&& (uint64_t)fileStat.st_size >= mappedHeader->countOffset + mappedHeader->chunkCount * sizeof(uint64_t);
+	if (!matches) {
+		munmap(mapping, fileStat.st_size);
+		close();
+		return false;
+	}
+
+	data = static_cast<char*>(mapping);
+	dataSize = fileStat.st_size;
+	header = mappedHeader;
+	statuses = reinterpret_cast<atomic<uint8_t>*>(data + header->statusOffset);
+	counts = reinterpret_cast<uint64_t*>(data + header->countOffset);
+	scanChunk = 0;
+	return true;
+}
+
+void FrontierFile::close() {
+	if (data != nullptr) {
+		munmap(data, dataSize);
+		data = nullptr;
+		header = nullptr;
+	}
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+}
+
+int FrontierFile::getDepth() {
+	return header->depth;
+}
+
+uint32_t FrontierFile::getFrameSize() {
+	return header->frameSize;
+}
+
+uint64_t FrontierFile::getFrameCount() {
+	return header->frameCount;
+}
+
+uint64_t FrontierFile::getChunkCount() {
+	return header->chunkCount;
+}
+
+bool FrontierFile::lockChunk(uint64_t chunk) {
+	struct flock lock = {};
+	lock.l_type = F_WRLCK;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = header->statusOffset + chunk;
+	lock.l_len = 1;
+	return fcntl(fd, F_OFD_SETLK, &lock) == 0;
+}
+
+void FrontierFile::unlockChunk(uint64_t chunk) {
+	struct flock lock = {};
+	lock.l_type = F_UNLCK;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = header->statusOffset + chunk;
+	lock.l_len = 1;
+	fcntl(fd, F_OFD_SETLK, &lock);
+}
+
+bool FrontierFile::claimChunk(uint64_t& chunk) {
+	// Chunks are handed out by the cursor first. A chunk whose lock is taken was found by a scan in the meantime
+	while (header->nextChunk.load(memory_order_relaxed) < header->chunkCount) {
+		uint64_t next = header->nextChunk.fetch_add(1);
+		if (next >= header->chunkCount || !lockChunk(next)) continue;
+		if (ChunkStatus(statuses[next].load(memory_order_acquire)) != ChunkStatus::DONE) {
+			statuses[next].store(uint8_t(ChunkStatus::CLAIMED));
+			chunk = next;
+			return true;
+		}
+		unlockChunk(next);
+	}
+
+	// Then any chunk not finished whose lock is free, as it was either abandoned by a worker that died, or handed out
+	// by the cursor but not yet locked
+	for (; scanChunk < header->chunkCount; ++scanChunk) {
+		if (ChunkStatus(statuses[scanChunk].load(memory_order_acquire)) == ChunkStatus::DONE
+			|| !lockChunk(scanChunk)) continue;
+		if (ChunkStatus(statuses[scanChunk].load(memory_order_acquire)) != ChunkStatus::DONE) {
+			statuses[scanChunk].store(uint8_t(ChunkStatus::CLAIMED));
+			chunk = scanChunk++;
+			return true;
+		}
+		unlockChunk(scanChunk);
+	}
+	return false;
+}
+
+const char* FrontierFile::getChunkFrames(uint64_t chunk, uint64_t& frameCount) {
+	uint64_t firstFrame = chunk * header->framesPerChunk;
+	frameCount = min<uint64_t>(header->framesPerChunk, header->frameCount - firstFrame);
+	return data + header->frameOffset + firstFrame * header->frameSize;
+}
+
+void FrontierFile::completeChunk(uint64_t chunk, uint64_t identityCount) {
+	counts[chunk] = identityCount;
+	statuses[chunk].store(uint8_t(ChunkStatus::DONE), memory_order_release);
+	unlockChunk(chunk);
+}
+
+uint64_t FrontierFile::getCompletedChunkCount(uint64_t& identityCount) {
+	uint64_t completedCount = 0;
+	identityCount = 0;
+	for (uint64_t chunk = 0; chunk < header->chunkCount; ++chunk) {
+		if (ChunkStatus(statuses[chunk].load(memory_order_acquire)) == ChunkStatus::DONE) {
+			identityCount += counts[chunk];
+			++completedCount;
+		}
+	}
+	return completedCount;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include "OutputWriter.h"
+
+using std::string;
+using std::atomic;
+
+// Layout of the start of a frontier file. Frames (frameSize bytes each) follow at frameOffset, grouped into chunks of
+// framesPerChunk frames (the last chunk holding any left over), followed by a status byte per chunk at statusOffset
+// and the cube identity count of each chunk searched (a uint64_t) at countOffset
+struct FrontierHeader {
+	char magic[8];
+	uint32_t version;
+	int32_t sideLength;
+	int32_t dimensionality;
+	int32_t depth; // Index of the non-axis segment each frame stops at
+	uint32_t frameSize;
+	uint32_t framesPerChunk;
+	uint64_t planHash;
+	uint64_t frameCount;
+	uint64_t chunkCount;
+	uint64_t frameOffset;
+	uint64_t statusOffset;
+	uint64_t countOffset;
+
+	// Next chunk never handed out, claimed by the workers of every process through a fetch_add
+	alignas(64) atomic<uint64_t> nextChunk;
+};
+
+enum class ChunkStatus : uint8_t {
+	UNCLAIMED,
+	CLAIMED,
+	DONE,
+};
+
+/*
+* Memory mapped file of the search frontier at the start of a non-axis segment (see Generator::buildFrontier()),
+* searched by any number of worker processes at once (see Generator::searchFrontier()). Each frame is the search state
+* at that point: the cells placed before the segment, from which the rest of the state follows.
+*
+* Workers open the file (each thread through an open file description of its own) and claim chunks of frames, first
+* from the shared cursor in the header, and once that has run out by scanning for chunks never finished. While a
+* worker searches a chunk it holds an OFD lock on the chunk's status byte, which the kernel drops if the worker dies,
+* so a chunk left claimed but unlocked was abandoned, and is reclaimed by the next worker to find it. Workers can so be
+* killed and restarted freely, losing at most the chunks they were searching. The file is built under a temporary name
+* and renamed into place once complete
+*/
+class FrontierFile {
+	// Building
+	OutputWriter writer;
+	string path;
+	string temporaryPath;
+	FrontierHeader buildHeader = {};
+
+	// Searching
+	int fd = -1;
+	char* data = nullptr; // Mapped file, or nullptr if not open
+	size_t dataSize = 0;
+	FrontierHeader* header = nullptr;
+	atomic<uint8_t>* statuses = nullptr;
+	uint64_t* counts = nullptr;
+	uint64_t scanChunk = 0; // Next chunk to look at once the cursor has run out
+
+	// Tries to take the OFD lock of the chunk's status byte (without waiting), or releases it
+	bool lockChunk(uint64_t chunk);
+	void unlockChunk(uint64_t chunk);
+
+public:
+	~FrontierFile();
+
+	// Starts building a frontier file of frames of frameSize bytes, returning false if it can't be created
+	bool create(const string& path, int sideLength, int dimensionality, uint64_t planHash, int depth,
+		uint32_t frameSize, uint32_t framesPerChunk);
+
+	// Appends a frame (frameSize bytes) to the file being built
+	void addFrame(const void* frame);
+
+	// Writes out the chunk tables and header, and moves the file into place, returning false if it couldn't be
+	bool finish();
+
+	// Maps the file for searching, returning false if it is missing or doesn't match the configuration and plan given
+	bool open(const string& path, int sideLength, int dimensionality, uint64_t planHash);
+	void close();
+
+	int getDepth();
+	uint32_t getFrameSize();
+	uint64_t getFrameCount();
+	uint64_t getChunkCount();
+
+	// Claims a chunk for searching, returning false once every chunk is finished or being searched by a live worker
+	bool claimChunk(uint64_t& chunk);
+
+	// The frames of the chunk, and their number
+	const char* getChunkFrames(uint64_t chunk, uint64_t& frameCount);
+
+	// Records the cube identity count of a claimed chunk and marks it finished
+	void completeChunk(uint64_t chunk, uint64_t identityCount);
+
+	// Number of chunks finished so far, and the sum of their cube identity counts
+	uint64_t getCompletedChunkCount(uint64_t& identityCount);
+};
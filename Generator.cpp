@@ -2,22 +2,96 @@
 #include <functional>
 #include <algorithm>
 #include "Cycle.h"
+#include "MeetInTheMiddle.h"
+#include "TransformationExpander.h"
+#include "ParallelSearch.h"
+#include "OrderedOutput.h"
+#include "SearchPaths.h"
+#include "FrontierFile.h"
 #include <iostream>
 #include <math.h>
 #include <thread>
 #include <chrono>
+#include <bit>
+#include <climits>
+#include <memory>
+#include <array>
+#include <charconv>
+#include <cstring>
 
 using namespace std;
 using namespace chrono;
 
-// Value cache for factorial
-vector<int> factSet(1, 1);
+// Longest segment permuteSegment() supports, as its feasible slots are tracked in 32 bit masks (far beyond any segment
+// length whose permutations could be enumerated anyway)
+const int maxPermutedSegmentLength = 32;
 
-int fact(int n) {
-	while (n >= factSet.size()) {
-		factSet.push_back(factSet.back() * factSet.size());
+// Most output a replica holds for the axis solidification set it is searching before handing it over to orderedOutput
+const size_t maxHeldOutputBytes = 1 << 20;
+
+// Nodes a sampling dive searches before giving up on its axis solidification set and restarting from another
+const unsigned long sampleNodeBudget = 1 << 16;
+
+// Sampling draws in a row finding no new cube after which sampling stops, as there are likely none left to find
+const unsigned long maxFruitlessSampleDraws = 1 << 24;
+
+// Most gather table entries compiled up front (256MB worth)
+const unsigned long maxGatherTableEntries = 1ul << 26;
+
+// Size of the shared memory ring cubes are streamed through (see setStreamName())
+const size_t streamRingBytes = size_t(64) << 20;
+
+// The search kernels are compiled for each of these instruction set levels, with the best one the CPU supports picked 
+// when the program loads (through an ifunc resolver checking cpuid), so a single portable binary still makes use of 
+// AVX2, BMI2 and AVX-512 where present
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+#define SEARCH_KERNEL __attribute__((target_clones("arch=x86-64-v4", "arch=x86-64-v3", "default")))
+#else
+#define SEARCH_KERNEL
+#endif
+
+// Segments up to this long are permuted by permuteShortSegment() rather than permuteSegment()
+const int maxShortSegmentLength = 3;
+
+// The swaps of Heap's algorithm generating every perm of up to maxShortSegmentLength cells, in the same order as 
+// permuteSegment() (the first length! - 1 of them generate the perms of length cells)
+constexpr int shortSegmentSwaps[5][2] = { { 0, 1 }, { 0, 2 }, { 0, 1 }, { 0, 2 }, { 0, 1 } };
+
+inline int isSlotInfeasible(uint32_t* feasibleSlotMasks, int* slots, int cell) {
+	return (feasibleSlotMasks[cell] >> slots[cell] & 1) ^ 1;
+}
+
+// Largest n whose factorial fits in an unsigned long
+const int maxExactFactorial = 20;
+
+// Factorials up to maxExactFactorial, worked out at compile time (so that threads never race to extend them)
+constexpr auto factSet = []() {
+	array<unsigned long, maxExactFactorial + 1> factorials = {};
+	factorials[0] = 1;
+	for (int n = 1; n <= maxExactFactorial; ++n) {
+		factorials[n] = factorials[n - 1] * n;
+	}
+	return factorials;
+}();
+
+// Factorial of n, saturating at ULONG_MAX beyond maxExactFactorial
+unsigned long fact(int n) {
+	return n <= maxExactFactorial ? factSet[n] : ULONG_MAX;
+}
+
+// Factorial of n as a double, for counts too large to be exact
+double factApproximation(int n) {
+	double factorial = 1;
+	for (int i = 2; i <= n; ++i) {
+		factorial *= i;
 	}
-	return factSet[n];
+	return factorial;
+}
+
+// Product of a and b, saturating at ULONG_MAX
+unsigned long multiplySaturating(unsigned long a, unsigned long b) {
+	unsigned long product;
+	return __builtin_mul_overflow(a, b, &product) ? ULONG_MAX : product;
 }
 
 void printTimeTaken(chrono::high_resolution_clock::time_point startTime) {
@@ -31,20 +105,21 @@ void printTimeTaken(chrono::high_resolution_clock::time_point startTime) {
 	cout << secs << endl;
 }
 
-Generator::Generator(int _sideLength, int _dimensionality) {
+template <typename Cell>
+Generator<Cell>::Generator(int _sideLength, int _dimensionality) {
 	//------------------------------
 	// Basic variable initialisation
 	//------------------------------
 
 	sideLength = _sideLength;
 	dimensionality = _dimensionality;
-	setSize = pow(sideLength, dimensionality);
-	originValue = 1; //setSize / 2;
+	setSize = 1;
 	for (int i = 0; i < dimensionality; ++i) {
-		dimensionScales.push_back(pow(sideLength, i));
+		dimensionScales.push_back(setSize);
+		setSize *= sideLength;
 	}
-	originalSum = (pow(sideLength, dimensionality + 1) + sideLength) / 2;
-	intraAxisSwapPrintIndices = vector<int>(dimensionality, 0);
+	originValue = 1; //setSize / 2;
+	originalSum = (Sum(setSize) * sideLength + sideLength) / 2;
 
 	//--------------------------------------------------------------------
 	// convSet, segmentInfoSet and solidifiedSegmentInfoSet initialisation
@@ -150,7 +225,7 @@ Generator::Generator(int _sideLength, int _dimensionality) {
 	inner1(axes, dimensionality - 1, subStructureScales, 0);
 
 	// Links each segmentInfo object to the next one in the set
-	for (int i = 0; i < solidifiedSegmentInfoSet.size(); ++i) {
+	for (size_t i = 0; i < solidifiedSegmentInfoSet.size(); ++i) {
 		solidifiedSegmentInfoSet[i].isAxisSegment = true;
 		solidifiedSegmentInfoSet[i].nextSegment = (i == solidifiedSegmentInfoSet.size() - 1 ? nullptr
 			: &solidifiedSegmentInfoSet[i + 1]);
@@ -159,7 +234,7 @@ Generator::Generator(int _sideLength, int _dimensionality) {
 	// Last segment is removed because if all previous segments are resolved, then the final segment is resolved by 
 	// definition
 	segmentInfoSet.pop_back();
-	for (int i = 0; i < segmentInfoSet.size(); ++i) {
+	for (size_t i = 0; i < segmentInfoSet.size(); ++i) {
 		segmentInfoSet[i].nextSegment = (i == segmentInfoSet.size() - 1 ? nullptr : &segmentInfoSet[i + 1]);
 	}
 
@@ -170,7 +245,7 @@ Generator::Generator(int _sideLength, int _dimensionality) {
 	// accomplished by creating an inverseConvSet (a mapping from segment coords to cube coords derived from the 
 	// convSet), manipulating that using segment coords, and then deriving the new convSet back from the inverseConvSet.
 	vector<int> inverseConvSet(convSet.size());
-	for (int i = 0; i < convSet.size(); ++i) {
+	for (int i = 0; i < setSize; ++i) {
 		inverseConvSet[convSet[i]] = i;
 	}
 
@@ -199,7 +274,7 @@ Generator::Generator(int _sideLength, int _dimensionality) {
 	}
 
 	// Maps transformations made on the inverseConvSet back onto the convSet
-	for (int i = 0; i < convSet.size(); ++i) {
+	for (int i = 0; i < setSize; ++i) {
 		convSet[inverseConvSet[i]] = i;
 	}
 
@@ -215,43 +290,264 @@ Generator::Generator(int _sideLength, int _dimensionality) {
 		}
 	}
 
+	//---------------------
+	// lines initialisation
+	//---------------------
 
-	//------------------------------------------------
-	// permSegmentSets and permSwapSets initialisation
-	//------------------------------------------------
-
-	// permSegmentSets is required by both row swapping and axis swapping, 
-	// and so needs to be large enough to satisfy both
-	int permSegmentLength = max(sideLength, dimensionality);
-	vector<int> set;
-	for (int i = 0; i < permSegmentLength; ++i) {
-		set.push_back(i);
+	// Every line starts at a cell whose coordinate along the line's axis is 0
+	for (int axis = 0; axis < dimensionality; ++axis) {
+		for (int i = 0; i < setSize; ++i) {
+			if ((i / dimensionScales[axis]) % sideLength == 0) {
+				vector<int> line;
+				for (int j = 0; j < sideLength; ++j) {
+					line.push_back(convSet[i + dimensionScales[axis] * j]);
+				}
+				lines.push_back(line);
+			}
+		}
 	}
 
-	// Recursively generates and fills permSegmentSet with every permutation of values -> [0, permSegmentLength - 1],
-	// as well as saving the swap indices to permSwapSet
-	function<void(int)> inner2 = [this, &set, &permSegmentLength, &inner2](int length) {
-		if (length == 1) {
-			permSegmentSets.push_back(set);
-		} else {
-			inner2(length - 1);
-			for (int i = 0; i < length - 1; i++) {
-				vector<int> swapSet = { length % 2 == 1 ? 0 : i, length - 1 };
-				swap(set[swapSet[0]], set[swapSet[1]]);
-				permSwapSets.push_back(swapSet);
-				inner2(length - 1);
+	// Saves, for each cell of each segment, the other lines crossing it (the segment's own line is the one containing 
+	// its sum complement)
+	for (SegmentInfo& segmentInfo : segmentInfoSet) {
+		for (int index = segmentInfo.start; index < segmentInfo.start + segmentInfo.length; ++index) {
+			vector<CrossingLine> cellCrossingLines;
+			for (vector<int>& line : lines) {
+				if (find(line.begin(), line.end(), index) == line.end()) continue;
+				if (find(line.begin(), line.end(), segmentInfo.sumComplementIndices[0]) != line.end()) continue;
+
+				CrossingLine crossingLine;
+				crossingLine.remainingCount = 0;
+				for (int lineIndex : line) {
+					if (lineIndex < segmentInfo.start) {
+						crossingLine.placedIndices.push_back(lineIndex);
+					} else if (lineIndex != index) {
+						++crossingLine.remainingCount;
+					}
+				}
+				cellCrossingLines.push_back(crossingLine);
 			}
+			segmentInfo.crossingLines.push_back(cellCrossingLines);
 		}
-	};
 
-	inner2(permSegmentLength);
+		for (vector<int>& line : lines) {
+			vector<int> placedIndices;
+			bool crossesBoundary = false;
+			for (int lineIndex : line) {
+				if (lineIndex < segmentInfo.start) {
+					placedIndices.push_back(lineIndex);
+				} else {
+					crossesBoundary = true;
+				}
+			}
+			if (crossesBoundary && !placedIndices.empty()) {
+				segmentInfo.boundaryLines.push_back(placedIndices);
+			}
+		}
+	}
+
+	// States only recur often enough to be worth keeping once few values remain, ie. for the segments within the last 
+	// line's worth of cells
+	for (SegmentInfo& segmentInfo : segmentInfoSet) {
+		segmentInfo.isTransposed = setSize - segmentInfo.start <= sideLength;
+	}
+	availableValueMask.resize((setSize + 63) / 64);
+	minCellValues.resize(setSize, 1);
+	maxCellValues.resize(setSize, setSize);
+	pinnedIndices.resize(setSize + 1, -1);
+	axisSegmentLength = solidifiedSegmentInfoSet[0].length;
+	axisCompletionKeySize = 2 * sizeof(int) + availableValueMask.size() * sizeof(uint64_t);
+	axisSetCachePath = "Axis Solidification Sets " + to_string(sideLength) + "^" + to_string(dimensionality) + ".cache";
+	subtreeCachePath = "Subtree Results " + to_string(sideLength) + "^" + to_string(dimensionality) + ".db";
+	statsPath = "Generator Stats " + to_string(sideLength) + "^" + to_string(dimensionality) + ".json";
+	counters = &telemetry.addThread();
+	maxCubeTextLength = setSize * (to_string(setSize).size() + 1);
+	for (int scale = sideLength; scale <= setSize; scale *= sideLength) {
+		maxCubeTextLength += setSize / scale; // Line ends
+	}
+	transformationCount = 1;
+	for (int axis = 0; axis < dimensionality; ++axis) {
+		transformationCount = multiplySaturating(transformationCount, fact(sideLength));
+	}
+	transformationCount = multiplySaturating(transformationCount, fact(dimensionality));
+	minAvailableSums.resize(sideLength + 1, 0);
+	maxAvailableSums.resize(sideLength + 1, 0);
+
+	//------------------------------
+	// heapRunEffects initialisation
+	//------------------------------
+
+	// Perms are required by both row swapping and axis swapping, and so need to cover the longer of the two. A run over 
+	// length cells is a run over the first length - 1 cells, followed by length - 1 rounds of a swap and another such run
+	int permSegmentLength = max(sideLength, dimensionality);
+	heapRunEffects.resize(permSegmentLength + 1);
+	for (int length = 1; length <= permSegmentLength; ++length) {
+		vector<int>& effect = heapRunEffects[length];
+		effect.resize(length);
+		for (int cell = 0; cell < length; ++cell) {
+			effect[cell] = cell;
+		}
+		vector<int> runEffect = effect;
+		for (int i = 0; i < length; ++i) {
+			if (i > 0) {
+				swap(effect[length % 2 == 1 ? 0 : i - 1], effect[length - 1]);
+			}
+			for (int cell = 0; cell < length - 1; ++cell) {
+				runEffect[cell] = effect[heapRunEffects[length - 1][cell]];
+			}
+			copy(runEffect.begin(), runEffect.begin() + length - 1, effect.begin());
+		}
+	}
 }
 
-void Generator::generate(PrintOption printOption) {
+template <typename Cell>
+bool Generator<Cell>::generate(PrintOption printOption, unsigned long firstAxisSolidificationSet, 
+	unsigned long axisSolidificationSetCount) {
 	this->printOption = printOption;
-	ofs = ofstream("Magic Cubes.txt");
+	if (!openOutput()) return false;
+
+	// First calculates the total number of axis solidification sets
+	cout << "Counting axis solidification sets..." << endl;
+	startTime = high_resolution_clock::now();
+	totalAxisSolidificationSetCount = countAxisSolidificationSets();
+	cout << "Total axis solidification sets: " << totalAxisSolidificationSetCount << endl;
+	printTimeTaken(startTime);
+
+	firstAxisSolidificationSet = min(firstAxisSolidificationSet, totalAxisSolidificationSetCount);
+	lastAxisSolidificationSet = firstAxisSolidificationSet 
+		+ min(axisSolidificationSetCount, totalAxisSolidificationSetCount - firstAxisSolidificationSet);
+
+	// Then actually generate all cubes
+	cout << endl << "Generating magic hypercubes..." << endl;
+	startTime = high_resolution_clock::now();
+	telemetry.start(firstAxisSolidificationSet, lastAxisSolidificationSet, totalAxisSolidificationSetCount, statsPath);
+	// Results of whole subtrees can only be recorded when the subtree is traversed by this search alone (and without 
+	// constraints), and only reused when no cubes need printing
+	constrainingSearch = !constrainedPositions.empty() && printOption != PrintOption::ALL;
+	walkingPrintOrder = printOption != PrintOption::NONE || constrainingSearch;
+	usingSubtreeCache = meetInTheMiddle == nullptr && constrainedPositions.empty() && !subtreeCachePath.empty() 
+		&& (subtreeCache.isOpen() || subtreeCache.open(subtreeCachePath, sideLength, dimensionality, getPlanHash()));
+	reusingSubtreeResults = usingSubtreeCache && printOption == PrintOption::NONE && !verifyingSubtreeCache;
+	reusedSubtreeCount = 0;
+	mismatchedSubtreeCount = 0;
+
+	// Compiles every transformation's gather table up front when they fit within the budget (any beyond it are compiled 
+	// as they are printed), and otherwise just the identity's
+	compileTransformations(printOption == PrintOption::ALL && transformationCount * setSize <= maxGatherTableEntries 
+		? transformationCount : 1);
 
-	vector<int> set;
+	// Every transformation of each identity is printed by a pool of expander threads, off the search thread
+	unique_ptr<TransformationExpander<Cell>> expander;
+	unsigned long printedCubeCount = 0;
+	if (printOption == PrintOption::ALL) {
+		expander = make_unique<TransformationExpander<Cell>>(*this, output, max(thread::hardware_concurrency(), 1u));
+		transformationExpander = expander.get();
+	}
+
+	// Counts can only be reused when nothing needs printing, and (the join not being part of the search) without the 
+	// meet-in-the-middle join
+	bool usingTranspositionTable = !walkingPrintOrder && meetInTheMiddle == nullptr;
+	transpositionTable.resize(usingTranspositionTable && threadCount == 1 ? transpositionTableSize : 0);
+
+	// Count-only runs place each axis solidification set directly from its rank, and then complete it with the 
+	// non-axis segments, whereas printing runs walk the axis solidification sets in the order the cubes are printed in, 
+	// passing over those before the first. Constrained count-only runs walk them likewise, as the constraints apply to 
+	// the arrangement each identity is printed in
+	this->firstAxisSolidificationSet = firstAxisSolidificationSet;
+	if (threadCount > 1 && meetInTheMiddle == nullptr) {
+		ParallelSearch<Cell> search(*this, threadCount);
+		search.run(firstAxisSolidificationSet, lastAxisSolidificationSet);
+	} else if (!walkingPrintOrder) {
+		vector<Cell> set(setSize);
+		for (unsigned long rank = firstAxisSolidificationSet; rank < lastAxisSolidificationSet; ++rank) {
+			traverseAxisSolidificationSet(rank, set);
+		}
+	} else {
+		walkAxisSolidificationSets();
+	}
+	if (meetInTheMiddle != nullptr) {
+		counters->cubeIdentityCount += meetInTheMiddle->finish();
+	}
+	if (expander != nullptr) {
+		expander->finish();
+		printedCubeCount = expander->getPrintedCubeCount();
+		transformationExpander = nullptr;
+	}
+
+	output.close();
+	ring.finish();
+
+	telemetry.stop();
+	unsigned long cubeIdentityCount = telemetry.read().cubeIdentityCount;
+	if (reusedSubtreeCount > 0) {
+		cout << "Reused recorded results for " << reusedSubtreeCount << " axis solidification sets from '" 
+			<< subtreeCachePath << "'" << endl;
+	}
+	if (usingTranspositionTable && transpositionTableSize > 0) {
+		TelemetrySnapshot snapshot = telemetry.read();
+		unsigned long lookupCount = snapshot.transpositionHitCount + snapshot.transpositionMissCount;
+		cout << "Transposition table hits: " << snapshot.transpositionHitCount << "/" << lookupCount << endl;
+	}
+	if (verifyingSubtreeCache) {
+		cout << "Axis solidification sets whose recorded results differ: " << mismatchedSubtreeCount << endl;
+	}
+	if (constrainingSearch) {
+		// Transformations of the identities found don't necessarily match the constraints themselves
+		cout << "Cube identities matching constraints: " << cubeIdentityCount << endl;
+	} else if (!constrainedPositions.empty()) {
+		cout << "Cube identities: " << cubeIdentityCount << endl;
+		cout << "Cubes matching constraints: " << printedCubeCount << endl;
+	} else {
+		cout << "Cube identities: " << cubeIdentityCount << endl;
+
+		// All permutations of intra-axis swaps within each axis, and inter-axis swaps between axes
+		cout << "Cubes: " << cubeIdentityCount * pow(factApproximation(sideLength), dimensionality) 
+			* factApproximation(dimensionality) << endl;
+	}
+	printTimeTaken(startTime);
+	return !output.hasFailed();
+}
+
+template <typename Cell>
+void Generator<Cell>::traverseAxisSolidificationSet(unsigned long rank, vector<Cell>& set) {
+	Generator& run = *primary;
+	if (run.reusingSubtreeResults) {
+		unsigned long recordedIdentityCount = 0;
+		bool recorded = false;
+		{
+			lock_guard<mutex> lock(run.sharedStateMutex);
+			const SubtreeResult* result = run.subtreeCache.find(rank);
+			if (result != nullptr) {
+				recordedIdentityCount = result->identityCount;
+				recorded = true;
+				++run.reusedSubtreeCount;
+			}
+		}
+		if (recorded) {
+			counters->cubeIdentityCount += recordedIdentityCount;
+			++counters->axisSolidificationSetCount;
+			return;
+		}
+	}
+
+	unsigned long identityCountBefore = counters->cubeIdentityCount;
+	unsigned long nodeCountBefore = counters->nodeCount;
+	high_resolution_clock::time_point subtreeStartTime = high_resolution_clock::now();
+	SegmentInfo& firstSegment = segmentInfoSet[0];
+	unrankAxisSolidificationSet(rank, set);
+	++counters->axisSolidificationSetCount;
+	resolveNonAxisSegment(set, firstSegment, firstSegment.start, 1, 
+		originalSum - set[firstSegment.sumComplementIndices[0]]);
+	if (run.usingSubtreeCache) {
+		recordSubtreeResult(rank, identityCountBefore, nodeCountBefore, subtreeStartTime);
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::walkAxisSolidificationSets() {
+	// The walk originally started from the set as counting the axis solidification sets left it, which (as each 
+	// further axis segment is resolved on a copy) comes down to walking the first axis segment
+	vector<Cell> set;
 	for (int i = 0; i < setSize; ++i) {
 		set.push_back(i + 1);
 	}
@@ -259,78 +555,336 @@ void Generator::generate(PrintOption printOption) {
 	// Makes the very first cell the origin value passed in
 	swap(set[0], set[originValue - 1]);
 
-	// First calculates the total number of axis solidification sets
+	SegmentInfo firstSegment = solidifiedSegmentInfoSet[0];
+	traversedAxisSolidificationSetCount = 0;
+	walkingOnly = true;
+	resolveSegment(set, firstSegment, firstSegment.start, setSize, setSize, originalSum - originValue);
+	walkingOnly = false;
+	resolveSegment(set, firstSegment, firstSegment.start, setSize, setSize, originalSum - originValue);
+}
+
+template <typename Cell>
+void Generator<Cell>::walkClaimedAxisSolidificationSets() {
+	// Each set claimed ahead of the walk becomes the next set it searches (see claimNextWalkedAxisSolidificationSet()), 
+	// so a walk only ends once the sets run out (firstAxisSolidificationSet is left at ULONG_MAX) or it has to restart
+	if (!parallelSearch->takeRank(parallelWorker, firstAxisSolidificationSet)) return;
+	while (firstAxisSolidificationSet != ULONG_MAX) {
+		lastAxisSolidificationSet = firstAxisSolidificationSet + 1;
+		walkAxisSolidificationSets();
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::claimNextWalkedAxisSolidificationSet() {
+	if (orderedOutput != nullptr) {
+		orderedOutput->write(traversedAxisSolidificationSetCount - 1, output.getBuffer(), heldIdentities, true);
+	}
+
+	unsigned long ordinal;
+	if (!parallelSearch->takeRank(parallelWorker, ordinal)) {
+		firstAxisSolidificationSet = ULONG_MAX;
+		lastAxisSolidificationSet = 0;
+		return;
+	}
+	firstAxisSolidificationSet = ordinal;
+	lastAxisSolidificationSet = ordinal >= traversedAxisSolidificationSetCount ? ordinal + 1 : 0;
+}
+
+template <typename Cell>
+bool Generator<Cell>::generateSample(unsigned long sampleCount, uint64_t seed, bool uniform) {
+	printOption = PrintOption::IDENTITIES;
+	if (!openOutput()) return false;
+
 	cout << "Counting axis solidification sets..." << endl;
-	generating = true;
-	calculatingAxisSolidificationSetCount = true;
 	startTime = high_resolution_clock::now();
-	thread progressDisplayThread1([this]() {
-		while (generating) {
-			this_thread::sleep_for((high_resolution_clock::now() - startTime) * 0.1);
-			cout << "Axis solidification set count: " << totalAxisSolidificationSetCount << " | ";
-			printTimeTaken(startTime);
-		}
-	});
+	totalAxisSolidificationSetCount = countAxisSolidificationSets();
+	cout << "Total axis solidification sets: " << totalAxisSolidificationSetCount << endl;
+	printTimeTaken(startTime);
 
-	SegmentInfo firstSegment = solidifiedSegmentInfoSet[0];
-	resolveSegment(set, firstSegment, firstSegment.start, setSize, setSize, originalSum - originValue);
-	generating = false;
-	progressDisplayThread1.join();
+	cout << endl << "Sampling magic hypercubes..." << endl;
+	startTime = high_resolution_clock::now();
+	samplingUniformly = uniform;
+	usingSubtreeCache = false;
+	reusingSubtreeResults = false;
+	fruitlessDrawCount = 0;
+	duplicateDrawCount = 0;
+	unordered_set<string> samples;
+	vector<thread> workers;
+	for (unsigned worker = 0; worker < threadCount && totalAxisSolidificationSetCount > 0; ++worker) {
+		workers.emplace_back([this, worker, seed, sampleCount, &samples]() {
+			// Each thread draws from a stream of its own, seeded from the seed and its index
+			Generator replica(*this, axisSetCache.isLoaded() ? nullptr : &axisCompletionCounts);
+			replica.sampleCubes(seed + worker * 0x9e3779b97f4a7c15ull, sampleCount, samples);
+		});
+	}
+	for (thread& worker : workers) {
+		worker.join();
+	}
+	output.close();
+	ring.finish();
+
+	if (samples.size() < sampleCount) {
+		cout << "Stopped after " << fruitlessDrawCount << " draws in a row without a new cube" << endl;
+	}
+	cout << "Sampled cubes: " << samples.size() << endl;
+	cout << "Draws: " << telemetry.read().axisSolidificationSetCount << endl;
+	printTimeTaken(startTime);
+	return !output.hasFailed();
+}
+
+template <typename Cell>
+bool Generator<Cell>::decodePaths(const string& path) {
+	SearchPathReader reader;
+	if (!reader.open(path, sideLength, dimensionality, getPlanHash())) {
+		cout << "Couldn't read '" << path << "' as a search path file of this configuration" << endl;
+		return false;
+	}
+	printOption = PrintOption::IDENTITIES;
+	if (!openOutput()) return false;
+
+	cout << "Counting axis solidification sets..." << endl;
+	startTime = high_resolution_clock::now();
+	totalAxisSolidificationSetCount = countAxisSolidificationSets();
 	cout << "Total axis solidification sets: " << totalAxisSolidificationSetCount << endl;
 	printTimeTaken(startTime);
 
-	// Then actually generate all cubes
-	cout << endl << "Generating magic hypercubes..." << endl;
-	calculatingAxisSolidificationSetCount = false;
-	generating = true;
+	cout << endl << "Decoding search paths..." << endl;
 	startTime = high_resolution_clock::now();
-	thread progressDisplayThread2([this]() { // TODO make a different thread so that joining between resolves works
-		while (generating) {
-			this_thread::sleep_for((high_resolution_clock::now() - startTime) * 0.1);
-			cout << "Cube identity count: " << cubeIdentityCount << " | Axis solidification set progress: "
-				<< traversedAxisSolidificationSetCount << "/" << totalAxisSolidificationSetCount << " | ";
-			printTimeTaken(startTime);
-		}
-	});
-	resolveSegment(set, firstSegment, firstSegment.start, setSize, setSize, originalSum - originValue);
+	compileTransformations(1);
+	vector<Cell> set(setSize);
+	vector<Cell> canonicalSet(setSize);
+	vector<Cell> segmentOrder(dimensionality);
+	unsigned long identityCount = 0;
+	bool valid = true;
+	unsigned long choice;
+	while (valid && !reader.isAtEnd()) {
+		// The axis solidification set is placed canonically, and its axis segments then reordered and arranged
+		valid = reader.readChoice(choice) && choice < totalAxisSolidificationSetCount;
+		if (!valid) break;
+		unrankAxisSolidificationSet(choice, canonicalSet);
+		set[0] = canonicalSet[0];
+		valid = reader.readChoice(choice) && choice < fact(dimensionality);
+		if (!valid) break;
+		for (int axisSegment = 0; axisSegment < dimensionality; ++axisSegment) {
+			segmentOrder[axisSegment] = axisSegment;
+		}
+		arrangeByRank(segmentOrder.data(), dimensionality, choice);
+		for (int axisSegment = 0; axisSegment < dimensionality && valid; ++axisSegment) {
+			SegmentInfo& segmentInfo = solidifiedSegmentInfoSet[axisSegment];
+			auto values = canonicalSet.begin() + solidifiedSegmentInfoSet[segmentOrder[axisSegment]].start;
+			copy(values, values + segmentInfo.length, set.begin() + segmentInfo.start);
+			valid = reader.readChoice(choice) && choice < fact(segmentInfo.length);
+			if (valid) arrangeByRank(set.data() + segmentInfo.start, segmentInfo.length, choice);
+		}
+
+		// Each non-axis segment then takes its combination of the values left, and arranges it
+		for (SegmentInfo& segmentInfo : segmentInfoSet) {
+			if (!valid) break;
+			Sum currSum = originalSum;
+			for (int index : segmentInfo.sumComplementIndices) {
+				currSum -= set[index];
+			}
+			valid = reader.readChoice(choice) && placeCombination(set, segmentInfo, currSum, choice) 
+				&& reader.readChoice(choice) && choice < fact(segmentInfo.length);
+			if (!valid) break;
+			arrangeByRank(set.data() + segmentInfo.start, segmentInfo.length, choice);
+			for (int i = segmentInfo.start; i < segmentInfo.start + segmentInfo.length; ++i) {
+				claimValue(set[i]);
+			}
+		}
+		if (!valid) break;
+
+		// The final cell of the set takes the one value left over
+		set[setSize - 1] = getFirstAvailableValue();
+		printCube(set, &gatherTables[0], output.getBuffer());
+		output.flushIfFull();
+		++identityCount;
+	}
+	output.close();
+	ring.finish();
+
+	if (!valid) {
+		cout << "'" << path << "' is truncated or corrupt after " << identityCount << " cube identities" << endl;
+	}
+	cout << "Decoded cube identities: " << identityCount << endl;
+	printTimeTaken(startTime);
+	return valid && !output.hasFailed();
+}
+
+template <typename Cell>
+void Generator<Cell>::sampleCubes(uint64_t seed, unsigned long sampleCount, unordered_set<string>& samples) {
+	Generator& run = *primary;
+	mt19937_64 threadRandom(seed);
+	random = &threadRandom;
+	samplingUniformly = run.samplingUniformly;
+	uniform_int_distribution<unsigned long> rankDistribution(0, run.totalAxisSolidificationSetCount - 1);
+	uniform_int_distribution<unsigned long> transformationDistribution(0, transformationCount - 1);
+	vector<Cell> set(setSize);
+	vector<int> scratchTable(setSize);
+	vector<unsigned long> allowedTransformations;
+	double maxSampleWeight = 0;
+	while (true) {
+		{
+			// Once every cube has been drawn, draws only find cubes already drawn. With n drawn, 10n duplicates in a row 
+			// while any are left is less likely than e^-10
+			lock_guard<mutex> lock(run.sharedStateMutex);
+			if (samples.size() >= sampleCount || run.fruitlessDrawCount >= maxFruitlessSampleDraws 
+				|| run.duplicateDrawCount >= 10 * samples.size() + 1000) break;
+		}
+
+		sampledSet.clear();
+		sampleWeight = run.totalAxisSolidificationSetCount;
+		nodeLimit = samplingUniformly ? ULONG_MAX : counters->nodeCount + sampleNodeBudget;
+		traverseAxisSolidificationSet(rankDistribution(threadRandom), set);
+
+		// Constraints are met by transformations rather than identities (any value can be moved to any cell), so the 
+		// search isn't restricted by them, and the cube is written as one of the transformations matching them
+		allowedTransformations.clear();
+		if (!sampledSet.empty() && !constrainedPositions.empty()) {
+			for (unsigned long transformation = 0; transformation < transformationCount; ++transformation) {
+				if (isCubeAllowed(sampledSet, getGatherTable(transformation, scratchTable))) {
+					allowedTransformations.push_back(transformation);
+				}
+			}
+			if (allowedTransformations.empty()) sampledSet.clear();
+		}
+		if (sampledSet.empty()) {
+			lock_guard<mutex> lock(run.sharedStateMutex);
+			++run.fruitlessDrawCount;
+			continue;
+		}
+
+		// A uniform dive reaches each identity with a probability of 1 / sampleWeight, so accepting it with a 
+		// probability in proportion to sampleWeight (and to the number of its transformations that may be written) 
+		// evens out the cubes. The largest weight possible is unknown, so the largest seen so far stands in for it
+		if (samplingUniformly) {
+			if (!constrainedPositions.empty()) sampleWeight *= allowedTransformations.size();
+			maxSampleWeight = max(maxSampleWeight, sampleWeight);
+			if (uniform_real_distribution<double>(0, maxSampleWeight)(threadRandom) >= sampleWeight) {
+				lock_guard<mutex> lock(run.sharedStateMutex);
+				++run.fruitlessDrawCount;
+				continue;
+			}
+		}
+
+		unsigned long transformation = allowedTransformations.empty() ? transformationDistribution(threadRandom) 
+			: allowedTransformations[uniform_int_distribution<size_t>(0, allowedTransformations.size() - 1)(threadRandom)];
+		const int* gatherTable = getGatherTable(transformation, scratchTable);
+		string text;
+		printCube(sampledSet, gatherTable, text);
+
+		lock_guard<mutex> lock(run.sharedStateMutex);
+		if (samples.size() < sampleCount && samples.insert(text).second) {
+			run.output.write(text);
+			run.fruitlessDrawCount = 0;
+			run.duplicateDrawCount = 0;
+		} else {
+			++run.fruitlessDrawCount;
+			++run.duplicateDrawCount;
+		}
+	}
+	random = nullptr;
+}
 
-	generating = false;
-	progressDisplayThread2.join();
-	cout << "Cube identities: " << cubeIdentityCount << endl;
+template <typename Cell>
+bool Generator<Cell>::generateMeetInTheMiddle(int splitSegmentIndex, size_t memoryLimit) {
+	// The join needs at least one non-axis segment on each side of the split
+	int segmentCount = segmentInfoSet.size();
+	if (segmentCount < 2) {
+		return generate(PrintOption::NONE);
+	}
+
+	// By default the second half is made as large as possible while the number of ways to fill it (ignoring sums, as 
+	// its enumeration is unconstrained by the first half) could still fit within the memory limit
+	if (splitSegmentIndex <= 0) {
+		double fillingLimit = memoryLimit / 128.0;
+		splitSegmentIndex = segmentCount - 1;
+		while (splitSegmentIndex > 1) {
+			double fillingCount = 1;
+			for (int i = segmentInfoSet[splitSegmentIndex - 1].start; i < setSize; ++i) {
+				fillingCount *= setSize - i + segmentInfoSet[splitSegmentIndex - 1].start - 1;
+			}
+			if (fillingCount > fillingLimit) break;
+			--splitSegmentIndex;
+		}
+	}
+	splitSegmentIndex = min(splitSegmentIndex, segmentCount - 1);
 
-	// All permutations of intra-axis swaps within each axis, and inter-axis swaps between axes
-	cout << "Cubes: " << cubeIdentityCount * pow(fact(sideLength), dimensionality) * fact(dimensionality) << endl;
+	cout << "Enumerating second half from segment " << splitSegmentIndex << " (set index " 
+		<< segmentInfoSet[splitSegmentIndex].start << ")..." << endl;
+	startTime = high_resolution_clock::now();
+	MeetInTheMiddle<Cell> join(*this, segmentInfoSet[splitSegmentIndex].start, memoryLimit);
+	join.enumerateSecondHalf();
+	cout << "Second half signatures: " << join.getSecondHalfSignatureCount() << endl;
 	printTimeTaken(startTime);
+	cout << endl;
+
+	meetInTheMiddle = &join;
+	joinSegment = &segmentInfoSet[splitSegmentIndex];
+	bool generated = generate(PrintOption::NONE);
+	meetInTheMiddle = nullptr;
+	joinSegment = nullptr;
+	return generated;
 }
 
-void Generator::resolveSegment(vector<int>& set, SegmentInfo& segmentInfo, int depth, int exemptPos, int segmentExemptPos, 
-	int currSum) {
+template <typename Cell>
+SEARCH_KERNEL void Generator<Cell>::resolveSegment(vector<Cell>& set, SegmentInfo& segmentInfo, int depth, int exemptPos, 
+	int segmentExemptPos, Sum currSum) {
+	// The rest of the axis solidification set walk lies beyond the last axis solidification set to generate
+	if (traversedAxisSolidificationSetCount >= lastAxisSolidificationSet && segmentInfo.isAxisSegment) return;
+
+	++counters->nodeCount;
 	if (depth == segmentInfo.start + segmentInfo.length - 1) {
 		if (validateSumCheckSegments(set, segmentInfo, currSum)) {
 			for (int i = depth; i < exemptPos; ++i) {
 				if (set[i] == currSum) {
 					swap(set[i], set[depth]);
-					if (segmentInfo.isAxisSegment) {
+					if (walkingOnly) {
+						// Only the swaps of the walk are wanted
+					} else if (segmentInfo.isAxisSegment) {
 						// If this solidifies the last axis segment then move onto subsequent non-axis segments, 
 						// otherwise continue with the next axis segment
 						bool isLastSegment = segmentInfo.nextSegment == nullptr;
-						if (isLastSegment && calculatingAxisSolidificationSetCount) {
-							++totalAxisSolidificationSetCount;
-						} else {
-							if (isLastSegment) {
-								++traversedAxisSolidificationSetCount;
+						if (isLastSegment && traversedAxisSolidificationSetCount++ < firstAxisSolidificationSet) {
+							// Passes over the axis solidification sets before the first to generate
+						} else if (isLastSegment) {
+							if (primary->usingSubtreeCache) {
+								// The subtree is recorded under the set's rank within the canonical order
+								unsigned long rank = getCanonicalAxisSolidificationSetRank(set);
+								unsigned long identityCountBefore = counters->cubeIdentityCount;
+								unsigned long nodeCountBefore = counters->nodeCount;
+								high_resolution_clock::time_point subtreeStartTime = high_resolution_clock::now();
+								resolveAxisSolidificationSet(set);
+								recordSubtreeResult(rank, identityCountBefore, nodeCountBefore, subtreeStartTime);
+							} else {
+								resolveAxisSolidificationSet(set);
+							}
+							if (parallelSearch != nullptr) {
+								claimNextWalkedAxisSolidificationSet();
 							}
-							vector<int> newSet(set);
-							SegmentInfo& nextSegment = isLastSegment ? segmentInfoSet[0] : *segmentInfo.nextSegment;
-							int newExemptPos = isLastSegment ? setSize : segmentExemptPos;
-							int newSum = originalSum - (isLastSegment ? set[nextSegment.sumComplementIndices[0]] : originValue);
-							resolveSegment(newSet, nextSegment, nextSegment.start, newExemptPos, segmentExemptPos, newSum);
+						} else {
+							vector<Cell> newSet(set);
+							SegmentInfo& nextSegment = *segmentInfo.nextSegment;
+							resolveSegment(newSet, nextSegment, nextSegment.start, segmentExemptPos, segmentExemptPos, 
+								originalSum - originValue);
 						}
 					} else {
 						if (segmentInfo.nextSegment == nullptr) {
-							print(set);
+							// The last segment's arrangement is left as the walk found it rather than permuted, and the 
+							// final cell of the set holds the one value left over
+							if (!constrainingSearch || (areValuesAllowed(set, segmentInfo.start, segmentInfo.length) 
+								&& isValueAllowed(setSize - 1, set[setSize - 1]))) {
+								print(set);
+							}
 						} else {
+							// Unlike resolveNonAxisSegment(), the swap walk only fixes a segment's values once complete
+							for (int j = segmentInfo.start; j <= depth; ++j) {
+								claimValue(set[j]);
+							}
 							permuteSegment(set, segmentInfo);
+							for (int j = segmentInfo.start; j <= depth; ++j) {
+								releaseValue(set[j]);
+							}
 						}
 					}
 					break;
@@ -356,9 +910,718 @@ void Generator::resolveSegment(vector<int>& set, SegmentInfo& segmentInfo, int d
 	}
 }
 
-bool Generator::validateSumCheckSegments(vector<int>& set, SegmentInfo& segmentInfo, int& currSum) {
+template <typename Cell>
+bool Generator<Cell>::buildFrontier(const string& path, int depth, unsigned framesPerChunk, 
+	unsigned long firstAxisSolidificationSet, unsigned long axisSolidificationSetCount) {
+	// Each frame holds the cells placed before the segment at depth
+	depth = clamp(depth, 0, int(segmentInfoSet.size()) - 1);
+	SegmentInfo& frontierSegment = segmentInfoSet[depth];
+	FrontierFile file;
+	if (!file.create(path, sideLength, dimensionality, getPlanHash(), depth, frontierSegment.start * sizeof(Cell), 
+		max(framesPerChunk, 1u))) {
+		cout << "Unable to create the frontier file '" << path << "'" << endl;
+		return false;
+	}
+	printOption = PrintOption::NONE;
+
+	cout << "Counting axis solidification sets..." << endl;
+	startTime = high_resolution_clock::now();
+	totalAxisSolidificationSetCount = countAxisSolidificationSets();
+	cout << "Total axis solidification sets: " << totalAxisSolidificationSetCount << endl;
+	printTimeTaken(startTime);
+
+	firstAxisSolidificationSet = min(firstAxisSolidificationSet, totalAxisSolidificationSetCount);
+	unsigned long lastAxisSolidificationSet = firstAxisSolidificationSet 
+		+ min(axisSolidificationSetCount, totalAxisSolidificationSetCount - firstAxisSolidificationSet);
+
+	// The search stops at the segment just as the meet-in-the-middle engine stops at its join segment
+	cout << endl << "Expanding the frontier at segment " << depth << " (set index " << frontierSegment.start 
+		<< ") into '" << path << "'..." << endl;
+	startTime = high_resolution_clock::now();
+	vector<Cell> set(setSize);
+	frontierFile = &file;
+	joinSegment = &frontierSegment;
+	for (unsigned long rank = firstAxisSolidificationSet; rank < lastAxisSolidificationSet; ++rank) {
+		if (depth == 0) {
+			unrankAxisSolidificationSet(rank, set);
+			file.addFrame(set.data());
+		} else {
+			traverseAxisSolidificationSet(rank, set);
+		}
+	}
+	frontierFile = nullptr;
+	joinSegment = nullptr;
+
+	if (!file.finish()) {
+		cout << "Unable to write the frontier file '" << path << "'" << endl;
+		return false;
+	}
+	file.open(path, sideLength, dimensionality, getPlanHash());
+	cout << "Frontier frames: " << file.getFrameCount() << " in " << file.getChunkCount() << " chunks" << endl;
+	printTimeTaken(startTime);
+	return true;
+}
+
+template <typename Cell>
+bool Generator<Cell>::searchFrontier(const string& path) {
+	FrontierFile file;
+	if (!file.open(path, sideLength, dimensionality, getPlanHash())) {
+		cout << "'" << path << "' is not a frontier file of this configuration and segment plan" << endl;
+		return false;
+	}
+	uint64_t identityCount;
+	cout << "Searching frontier '" << path << "' at segment " << file.getDepth() << ": " << file.getFrameCount() 
+		<< " frames in " << file.getChunkCount() << " chunks, " << file.getCompletedChunkCount(identityCount) 
+		<< " already searched" << endl;
+
+	startTime = high_resolution_clock::now();
+	printOption = PrintOption::NONE;
+	unsigned long searchedChunkCount = 0;
+	vector<thread> workers;
+	for (unsigned worker = 0; worker < threadCount; ++worker) {
+		workers.emplace_back([this, &path, &searchedChunkCount]() {
+			Generator replica(*this, nullptr);
+			replica.searchFrontierChunks(path, searchedChunkCount);
+		});
+	}
+	for (thread& worker : workers) {
+		worker.join();
+	}
+
+	// Chunks still being searched by other processes are left to them to report
+	cout << "Chunks searched: " << searchedChunkCount << endl;
+	uint64_t completedChunkCount = file.getCompletedChunkCount(identityCount);
+	if (completedChunkCount < file.getChunkCount()) {
+		cout << "Chunks remaining: " << file.getChunkCount() - completedChunkCount << endl;
+	} else {
+		cout << "Cube identities: " << identityCount << endl;
+		cout << "Cubes: " << identityCount * pow(factApproximation(sideLength), dimensionality) 
+			* factApproximation(dimensionality) << endl;
+	}
+	printTimeTaken(startTime);
+	return true;
+}
+
+template <typename Cell>
+void Generator<Cell>::searchFrontierChunks(const string& path, unsigned long& searchedChunkCount) {
+	// Each thread claims chunks through its own open file description, whose locks are its own
+	Generator& run = *primary;
+	FrontierFile file;
+	if (!file.open(path, sideLength, dimensionality, getPlanHash())) return;
+
+	int depth = file.getDepth();
+	SegmentInfo& firstSegment = segmentInfoSet[0];
+	int frameLength = segmentInfoSet[depth].start;
+	vector<Cell> set(setSize);
+	uint64_t chunk;
+	while (file.claimChunk(chunk)) {
+		unsigned long identityCountBefore = counters->cubeIdentityCount;
+		uint64_t frameCount;
+		const Cell* frames = reinterpret_cast<const Cell*>(file.getChunkFrames(chunk, frameCount));
+		for (uint64_t frame = 0; frame < frameCount; ++frame) {
+			// The availability state follows from the cells placed
+			copy(frames + frame * frameLength, frames + (frame + 1) * frameLength, set.begin());
+			resetAvailableValues();
+			for (int index = 0; index < frameLength; ++index) {
+				claimValue(set[index]);
+			}
+			if (depth == 0) {
+				resolveNonAxisSegment(set, firstSegment, firstSegment.start, 1, 
+					originalSum - set[firstSegment.sumComplementIndices[0]]);
+			} else {
+				resolveNextSegment(set, segmentInfoSet[depth - 1]);
+			}
+		}
+		file.completeChunk(chunk, counters->cubeIdentityCount - identityCountBefore);
+
+		lock_guard<mutex> lock(run.sharedStateMutex);
+		++searchedChunkCount;
+	}
+}
+
+template <typename Cell>
+unsigned long Generator<Cell>::countAxisSolidificationSets() {
+	generateShellPartials();
+	resetAvailableValues();
+	if (!axisSetCachePath.empty() && (axisSetCache.isLoaded() 
+		|| axisSetCache.load(axisSetCachePath, sideLength, dimensionality, getPlanHash(), axisCompletionKeySize))) {
+		cout << "Read axis solidification sets from '" << axisSetCachePath << "'" << endl;
+		return axisSetCache.getAxisSolidificationSetCount();
+	}
+
+	unsigned long count = countAxisCompletions(0, 1);
+	if (!axisSetCachePath.empty()) {
+		axisSetCache.save(axisSetCachePath, sideLength, dimensionality, getPlanHash(), axisCompletionKeySize, count, 
+			axisCompletionCounts);
+	}
+	return count;
+}
+
+template <typename Cell>
+void Generator<Cell>::setAxisSetCachePath(const string& path) {
+	axisSetCachePath = path;
+}
+
+template <typename Cell>
+void Generator<Cell>::setSubtreeCachePath(const string& path) {
+	subtreeCachePath = path;
+}
+
+template <typename Cell>
+void Generator<Cell>::setStatsPath(const string& path) {
+	statsPath = path;
+}
+
+template <typename Cell>
+void Generator<Cell>::setStreamName(const string& name) {
+	streamName = name;
+	streaming = !name.empty();
+}
+
+template <typename Cell>
+void Generator<Cell>::setTranspositionTableSize(size_t bytes) {
+	transpositionTableSize = bytes;
+}
+
+template <typename Cell>
+void Generator<Cell>::setThreadCount(unsigned count) {
+	threadCount = max(count, 1u);
+}
+
+template <typename Cell>
+void Generator<Cell>::setVerifyingSubtreeCache(bool verifying) {
+	verifyingSubtreeCache = verifying;
+}
+
+template <typename Cell>
+Generator<Cell>::Generator(Generator& _primary, const unordered_map<string, unsigned long>* _sharedAxisCompletionCounts)
+	: Generator(_primary.sideLength, _primary.dimensionality) {
+	primary = &_primary;
+	counters = &primary->telemetry.addThread();
+	printOption = primary->printOption;
+	streaming = primary->streaming;
+	walkingPrintOrder = primary->walkingPrintOrder;
+	transformationExpander = primary->transformationExpander;
+	if (printOption == PrintOption::IDENTITIES) {
+		compileTransformations(1);
+	}
+	if (!walkingPrintOrder && primary->meetInTheMiddle == nullptr) {
+		transpositionTable.resize(primary->transpositionTableSize / primary->threadCount);
+	}
+	if (primary->axisSetCache.isLoaded()) {
+		axisSetCache.load(primary->axisSetCachePath, sideLength, dimensionality, getPlanHash(), axisCompletionKeySize);
+	}
+	sharedAxisCompletionCounts = _sharedAxisCompletionCounts;
+	minCellValues = primary->minCellValues;
+	maxCellValues = primary->maxCellValues;
+	pinnedIndices = primary->pinnedIndices;
+	constrainedPositions = primary->constrainedPositions;
+	constrainingSearch = primary->constrainingSearch;
+}
+
+template <typename Cell>
+uint64_t Generator<Cell>::getPlanHash() {
+	// FNV-1a over the configuration and the layout of every segment
+	uint64_t hash = 14695981039346656037ull;
+	auto addValue = [&hash](int value) {
+		hash = (hash ^ uint32_t(value)) * 1099511628211ull;
+	};
+	addValue(sideLength);
+	addValue(dimensionality);
+	addValue(originValue);
+	for (int index : convSet) {
+		addValue(index);
+	}
+	for (vector<SegmentInfo>* segmentInfos : { &solidifiedSegmentInfoSet, &segmentInfoSet }) {
+		for (SegmentInfo& segmentInfo : *segmentInfos) {
+			addValue(segmentInfo.start);
+			addValue(segmentInfo.length);
+			for (int index : segmentInfo.sumComplementIndices) {
+				addValue(index);
+			}
+		}
+	}
+	return hash;
+}
+
+template <typename Cell>
+void Generator<Cell>::unrankAxisSolidificationSet(unsigned long rank, vector<Cell>& set) {
+	generateShellPartials();
+	resetAvailableValues();
+	set[0] = originValue;
+	int minValue = 1;
+	for (int axisSegment = 0; axisSegment < dimensionality; ++axisSegment) {
+		// Skips over the subtrees of the partials before the one whose subtree contains the rank
+		int partial = findAvailableShellPartial(firstShellPartials[minValue]);
+		for (; partial < shellPartialCount; partial = findAvailableShellPartial(partial + 1)) {
+			unsigned long count = countAxisCompletionsWithPartial(axisSegment, partial);
+			if (rank < count) break;
+			rank -= count;
+		}
+
+		const int* values = &shellPartialValues[partial * axisSegmentLength];
+		copy(values, values + axisSegmentLength, set.begin() + solidifiedSegmentInfoSet[axisSegment].start);
+		claimShellPartial(partial);
+		minValue = values[0] + 1;
+	}
+}
+
+template <typename Cell>
+unsigned long Generator<Cell>::rankAxisSolidificationSet(vector<Cell>& set) {
+	generateShellPartials();
+	resetAvailableValues();
+	unsigned long rank = 0;
+	int minValue = 1;
+	for (int axisSegment = 0; axisSegment < dimensionality; ++axisSegment) {
+		// Adds the subtrees of the partials before the segment's own
+		auto segmentValues = set.begin() + solidifiedSegmentInfoSet[axisSegment].start;
+		int partial = findAvailableShellPartial(firstShellPartials[minValue]);
+		for (; partial < shellPartialCount; partial = findAvailableShellPartial(partial + 1)) {
+			const int* values = &shellPartialValues[partial * axisSegmentLength];
+			if (equal(values, values + axisSegmentLength, segmentValues)) break;
+			rank += countAxisCompletionsWithPartial(axisSegment, partial);
+		}
+
+		claimShellPartial(partial);
+		minValue = *segmentValues + 1;
+	}
+	return rank;
+}
+
+template <typename Cell>
+void Generator<Cell>::generateShellPartials() {
+	if (!firstShellPartials.empty()) return;
+
+	// Recursively generates every ascending combination of values (skipping the origin value) that completes an axis 
+	// segment, in canonical order
+	vector<int> partialValues(axisSegmentLength);
+	function<void(int, int, Sum)> addPartials = [this, &partialValues, &addPartials](int depth, int minValue, 
+		Sum currSum) {
+		if (depth == axisSegmentLength) {
+			shellPartialValues.insert(shellPartialValues.end(), partialValues.begin(), partialValues.end());
+			size_t maskStart = shellPartialMasks.size();
+			shellPartialMasks.resize(maskStart + availableValueMask.size(), 0);
+			for (int value : partialValues) {
+				shellPartialMasks[maskStart + (value - 1) / 64] |= uint64_t(1) << ((value - 1) % 64);
+			}
+			return;
+		}
+
+		int lowValue, highValue;
+		getCandidateBounds(axisSegmentLength - depth, minValue, currSum, lowValue, highValue);
+		for (int value = lowValue; value <= highValue; ++value) {
+			if (value == originValue) continue;
+
+			partialValues[depth] = value;
+			addPartials(depth + 1, value + 1, currSum - value);
+		}
+	};
+
+	addPartials(0, 1, originalSum - originValue);
+	shellPartialCount = shellPartialValues.size() / axisSegmentLength;
+
+	// Indexes the groups, walking back from the last partial
+	firstShellPartials.resize(setSize + 2);
+	int partial = shellPartialCount;
+	for (int value = setSize + 1; value >= 1; --value) {
+		while (partial > 0 && shellPartialValues[(partial - 1) * axisSegmentLength] >= value) {
+			--partial;
+		}
+		firstShellPartials[value] = partial;
+	}
+}
+
+template <typename Cell>
+int Generator<Cell>::findAvailableShellPartial(int partial) {
+	while (partial < shellPartialCount) {
+		int firstValue = shellPartialValues[partial * axisSegmentLength];
+		if (!isValueAvailable(firstValue)) {
+			partial = firstShellPartials[firstValue + 1];
+			continue;
+		}
+
+		// Available when none of its values are missing from the availability mask
+		const uint64_t* mask = &shellPartialMasks[partial * availableValueMask.size()];
+		uint64_t missing = 0;
+		for (size_t i = 0; i < availableValueMask.size(); ++i) {
+			missing |= mask[i] & ~availableValueMask[i];
+		}
+		if (missing == 0) return partial;
+		++partial;
+	}
+	return shellPartialCount;
+}
+
+template <typename Cell>
+void Generator<Cell>::claimShellPartial(int partial) {
+	const uint64_t* mask = &shellPartialMasks[partial * availableValueMask.size()];
+	for (size_t i = 0; i < availableValueMask.size(); ++i) {
+		availableValueMask[i] &= ~mask[i];
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::releaseShellPartial(int partial) {
+	const uint64_t* mask = &shellPartialMasks[partial * availableValueMask.size()];
+	for (size_t i = 0; i < availableValueMask.size(); ++i) {
+		availableValueMask[i] |= mask[i];
+	}
+}
+
+template <typename Cell>
+unsigned long Generator<Cell>::countAxisCompletions(int axisSegment, int minValue) {
+	if (axisSegment == dimensionality) return 1;
+
+	// The state at the start of an axis segment comes down to the segment, the smallest first value allowed, and the 
+	// values available (keyed by the segment's first axis cell, as the axis set cache file always has been)
+	string key;
+	key.resize(axisCompletionKeySize);
+	int* state = reinterpret_cast<int*>(key.data());
+	state[0] = axisSegment * axisSegmentLength;
+	state[1] = minValue;
+	copy(availableValueMask.begin(), availableValueMask.end(), reinterpret_cast<uint64_t*>(state + 2));
+	unsigned long count;
+	if (axisSetCache.isLoaded() && axisSetCache.find(key, count)) return count;
+	if (sharedAxisCompletionCounts != nullptr) {
+		auto iter = sharedAxisCompletionCounts->find(key);
+		if (iter != sharedAxisCompletionCounts->end()) return iter->second;
+	}
+	auto iter = axisCompletionCounts.find(key);
+	if (iter != axisCompletionCounts.end()) return iter->second;
+
+	count = 0;
+	int partial = findAvailableShellPartial(firstShellPartials[minValue]);
+	for (; partial < shellPartialCount; partial = findAvailableShellPartial(partial + 1)) {
+		count += countAxisCompletionsWithPartial(axisSegment, partial);
+	}
+	axisCompletionCounts.emplace(key, count);
+	return count;
+}
+
+template <typename Cell>
+unsigned long Generator<Cell>::countAxisCompletionsWithPartial(int axisSegment, int partial) {
+	claimShellPartial(partial);
+	unsigned long count = countAxisCompletions(axisSegment + 1, shellPartialValues[partial * axisSegmentLength] + 1);
+	releaseShellPartial(partial);
+	return count;
+}
+
+template <typename Cell>
+void Generator<Cell>::resolveAxisSolidificationSet(vector<Cell>& set) {
+	++counters->axisSolidificationSetCount;
+
+	// Axis solidification sets placing values where the constraints don't allow have nothing to search
+	if (constrainingSearch) {
+		bool isAllowed = isValueAllowed(0, set[0]);
+		for (SegmentInfo& segmentInfo : solidifiedSegmentInfoSet) {
+			isAllowed = isAllowed && areValuesAllowed(set, segmentInfo.start, segmentInfo.length);
+		}
+		if (!isAllowed) return;
+	}
+
+	// The choices placing the axis solidification set are shared by the search paths of every identity it has
+	if (printOption == PrintOption::PATHS) {
+		axisPath.clear();
+		appendAxisPath(set, axisPath);
+	}
+
+	vector<Cell> newSet(set);
+	initialiseAvailableValues(newSet);
+	SegmentInfo& nextSegment = segmentInfoSet[0];
+	resolveSegment(newSet, nextSegment, nextSegment.start, setSize, setSize, 
+		originalSum - set[nextSegment.sumComplementIndices[0]]);
+}
+
+template <typename Cell>
+unsigned long Generator<Cell>::getCanonicalAxisSolidificationSetRank(vector<Cell>& set) {
+	// Sorts the values of each axis segment, and then the axis segments by their first value
+	vector<vector<Cell>> segments;
+	for (SegmentInfo& segmentInfo : solidifiedSegmentInfoSet) {
+		segments.emplace_back(set.begin() + segmentInfo.start, set.begin() + segmentInfo.start + segmentInfo.length);
+		sort(segments.back().begin(), segments.back().end());
+	}
+	sort(segments.begin(), segments.end());
+
+	vector<Cell> canonicalSet(set);
+	for (size_t i = 0; i < segments.size(); ++i) {
+		copy(segments[i].begin(), segments[i].end(), canonicalSet.begin() + solidifiedSegmentInfoSet[i].start);
+	}
+	return rankAxisSolidificationSet(canonicalSet);
+}
+
+template <typename Cell>
+void Generator<Cell>::recordSubtreeResult(unsigned long rank, unsigned long identityCountBefore, unsigned long nodeCountBefore, 
+	high_resolution_clock::time_point subtreeStartTime) {
+	SubtreeResult result;
+	result.rank = rank;
+	result.identityCount = counters->cubeIdentityCount - identityCountBefore;
+	result.nodeCount = counters->nodeCount - nodeCountBefore;
+	result.seconds = duration<double>(high_resolution_clock::now() - subtreeStartTime).count();
+	Generator& run = *primary;
+	lock_guard<mutex> lock(run.sharedStateMutex);
+	const SubtreeResult* cachedResult = run.subtreeCache.find(rank);
+	if (cachedResult != nullptr && cachedResult->identityCount != result.identityCount) {
+		cout << "Axis solidification set " << rank << " yielded " << result.identityCount 
+			<< " cube identities, but " << cachedResult->identityCount << " were recorded" << endl;
+		++run.mismatchedSubtreeCount;
+	}
+	run.subtreeCache.record(result);
+}
+
+template <typename Cell>
+SEARCH_KERNEL void Generator<Cell>::resolveNonAxisSegment(vector<Cell>& set, SegmentInfo& segmentInfo, int depth, 
+	int minValue, Sum currSum) {
+	++counters->nodeCount;
+	int remainingCount = segmentInfo.start + segmentInfo.length - depth;
+	if (remainingCount == 1) {
+		if (currSum < minValue || currSum > setSize || !isValueAvailable(currSum) 
+			|| !validateSumCheckSegments(set, segmentInfo, currSum)) return;
+
+		set[depth] = currSum;
+		claimValue(currSum);
+		if (segmentInfo.nextSegment == nullptr) {
+			// The final cell of the set takes the one value left over
+			set[setSize - 1] = getFirstAvailableValue();
+			print(set);
+		} else if (random != nullptr) {
+			// Sampling walks the perms from a random arrangement, which only permuteSegment() does
+			permuteSegment(set, segmentInfo);
+		} else {
+			// Most nodes lie within the short segments at the end of the plan, which have kernels of their own
+			switch (segmentInfo.length) {
+			case 1:
+				permuteShortSegment<1>(set, segmentInfo);
+				break;
+			case 2:
+				permuteShortSegment<2>(set, segmentInfo);
+				break;
+			case 3:
+				permuteShortSegment<3>(set, segmentInfo);
+				break;
+			default:
+				permuteSegment(set, segmentInfo);
+				break;
+			}
+		}
+		releaseValue(currSum);
+		return;
+	}
+
+	int lowValue, highValue;
+	getCandidateBounds(remainingCount, minValue, currSum, lowValue, highValue);
+	if (random != nullptr) {
+		sampleCandidates(set, segmentInfo, depth, lowValue, highValue, currSum);
+		return;
+	}
+
+	int lowBit = lowValue - 1;
+	int highBit = highValue - 1;
+	for (int i = max(lowBit, 0) / 64; i <= highBit / 64 && lowBit <= highBit; ++i) {
+		// Walks the available values of the word that lie within [lowBit, highBit]. Deeper cells only claim larger 
+		// values, and release them again before returning, so the word can be read once up front
+		uint64_t word = availableValueMask[i];
+		if (lowBit > i * 64) word &= ~uint64_t(0) << (lowBit - i * 64);
+		if (highBit < i * 64 + 63) word &= ~(~uint64_t(0) << (highBit - i * 64 + 1));
+		for (; word != 0; word &= word - 1) {
+			int value = i * 64 + countr_zero(word) + 1;
+			set[depth] = value;
+			claimValue(value);
+			resolveNonAxisSegment(set, segmentInfo, depth + 1, value + 1, currSum - value);
+			releaseValue(value);
+		}
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::sampleCandidates(vector<Cell>& set, SegmentInfo& segmentInfo, int depth, int lowValue, 
+	int highValue, Sum currSum) {
+	vector<int> candidates;
+	for (int value = max(lowValue, 1); value <= highValue; ++value) {
+		if (isValueAvailable(value)) {
+			candidates.push_back(value);
+		}
+	}
+	if (samplingUniformly) {
+		if (candidates.empty()) return;
+		sampleWeight *= candidates.size();
+		candidates = { candidates[uniform_int_distribution<size_t>(0, candidates.size() - 1)(*random)] };
+	} else {
+		shuffle(candidates.begin(), candidates.end(), *random);
+	}
+
+	for (int value : candidates) {
+		// Once a cube is found (or the budget runs out) every node returns straight away
+		if (counters->nodeCount >= nodeLimit) return;
+
+		set[depth] = value;
+		claimValue(value);
+		resolveNonAxisSegment(set, segmentInfo, depth + 1, value + 1, currSum - value);
+		releaseValue(value);
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::getCandidateBounds(int remainingCount, int minValue, Sum currSum, int& lowValue, 
+	int& highValue) {
+	// With the values ascending, the remaining cells make up at least remainingCount consecutive values starting from 
+	// this one, and the cells after this one at most the largest remainingCount - 1 values
+	Sum tailCount = remainingCount - 1;
+	lowValue = max<Sum>(minValue, currSum - (tailCount * setSize - tailCount * (tailCount - 1) / 2));
+
+	// Sums too large to leave any bound below setSize are cut short, so that the division stays a 32 bit one
+	Sum highSum = currSum - remainingCount * tailCount / 2;
+	highValue = highSum >= Sum(setSize) * remainingCount ? setSize : int(highSum) / remainingCount;
+}
+
+template <typename Cell>
+void Generator<Cell>::resetAvailableValues() {
+	fill(availableValueMask.begin(), availableValueMask.end(), 0);
+	for (int value = 1; value <= setSize; ++value) {
+		releaseValue(value);
+	}
+	claimValue(originValue);
+}
+
+template <typename Cell>
+void Generator<Cell>::initialiseAvailableValues(vector<Cell>& set) {
+	fill(availableValueMask.begin(), availableValueMask.end(), 0);
+	for (int i = segmentInfoSet[0].start; i < setSize; ++i) {
+		releaseValue(set[i]);
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::claimValue(int value) {
+	availableValueMask[(value - 1) / 64] &= ~(uint64_t(1) << ((value - 1) % 64));
+}
+
+template <typename Cell>
+bool Generator<Cell>::isValueAvailable(int value) {
+	return availableValueMask[(value - 1) / 64] >> ((value - 1) % 64) & 1;
+}
+
+template <typename Cell>
+int Generator<Cell>::getFirstAvailableValue() {
+	for (int i = 0; i < int(availableValueMask.size()); ++i) {
+		if (availableValueMask[i] != 0) {
+			return i * 64 + countr_zero(availableValueMask[i]) + 1;
+		}
+	}
+	return 0;
+}
+
+template <typename Cell>
+void Generator<Cell>::releaseValue(int value) {
+	availableValueMask[(value - 1) / 64] |= uint64_t(1) << ((value - 1) % 64);
+}
+
+template <typename Cell>
+bool Generator<Cell>::isSumReachable(int remainingCount, Sum residual) {
+	if (remainingCount == 0) return residual == 0;
+
+	// A single remaining cell has to take exactly the residual
+	if (remainingCount == 1) {
+		return residual >= 1 && residual <= setSize && isValueAvailable(residual);
+	}
+
+	// The residual has to lie between the sums of the smallest and largest available values. Those sums only change 
+	// when availability does, which is far less often than lines are checked (eg. never between the perms of a 
+	// segment, as deeper segments restore availability on their way out), and so they are cached against the mask
+	if (availableValueMask != availableSumsMask) {
+		updateAvailableSums();
+	}
+	return minAvailableSums[remainingCount] <= residual && residual <= maxAvailableSums[remainingCount];
+}
+
+template <typename Cell>
+void Generator<Cell>::updateAvailableSums() {
+	// Walks the set bits of the availability mask from either end
+	int count = 0;
+	for (int i = 0; i < int(availableValueMask.size()) && count < sideLength; ++i) {
+		for (uint64_t word = availableValueMask[i]; word != 0 && count < sideLength; word &= word - 1) {
+			minAvailableSums[count + 1] = minAvailableSums[count] + i * 64 + countr_zero(word) + 1;
+			++count;
+		}
+	}
+	for (; count < sideLength; ++count) {
+		minAvailableSums[count + 1] = numeric_limits<Sum>::max();
+	}
+
+	count = 0;
+	for (int i = availableValueMask.size() - 1; i >= 0 && count < sideLength; --i) {
+		for (uint64_t word = availableValueMask[i]; word != 0 && count < sideLength; ++count) {
+			int bit = bit_width(word) - 1;
+			maxAvailableSums[count + 1] = maxAvailableSums[count] + i * 64 + bit + 1;
+			word &= ~(uint64_t(1) << bit);
+		}
+	}
+	for (; count < sideLength; ++count) {
+		maxAvailableSums[count + 1] = numeric_limits<Sum>::min();
+	}
+	availableSumsMask = availableValueMask;
+}
+
+template <typename Cell>
+bool Generator<Cell>::isValueAllowed(int index, int value) {
+	return minCellValues[index] <= value && value <= maxCellValues[index] 
+		&& (pinnedIndices[value] < 0 || pinnedIndices[value] == index);
+}
+
+template <typename Cell>
+bool Generator<Cell>::areValuesAllowed(vector<Cell>& set, int start, int length) {
+	for (int index = start; index < start + length; ++index) {
+		if (!isValueAllowed(index, set[index])) return false;
+	}
+	return true;
+}
+
+template <typename Cell>
+uint32_t Generator<Cell>::getAllowedSlotMask(const Cell* values, int length, int index) {
+	uint32_t mask = 0;
+	for (int slot = 0; slot < length; ++slot) {
+		mask |= uint32_t(isValueAllowed(index, values[slot])) << slot;
+	}
+	return mask;
+}
+
+template <typename Cell>
+bool Generator<Cell>::isCubeAllowed(vector<Cell>& set, const int* gatherTable) {
+	// Every value appears once in every cube, so values pinned elsewhere need no checking
+	for (int position : constrainedPositions) {
+		int index = convSet[position];
+		int value = set[gatherTable[position]];
+		if (value < minCellValues[index] || value > maxCellValues[index]) return false;
+	}
+	return true;
+}
+
+template <typename Cell>
+bool Generator<Cell>::addConstraint(const vector<int>& coords, int minValue, int maxValue) {
+	if (int(coords.size()) != dimensionality || minValue < 1 || maxValue > setSize || minValue > maxValue) return false;
+
+	int position = 0;
+	for (int axis = 0; axis < dimensionality; ++axis) {
+		if (coords[axis] < 0 || coords[axis] >= sideLength) return false;
+		position += coords[axis] * dimensionScales[axis];
+	}
+
+	int index = convSet[position];
+	if (find(constrainedPositions.begin(), constrainedPositions.end(), position) == constrainedPositions.end()) {
+		constrainedPositions.push_back(position);
+	}
+	minCellValues[index] = max(minCellValues[index], minValue);
+	maxCellValues[index] = min(maxCellValues[index], maxValue);
+	if (minCellValues[index] == maxCellValues[index]) {
+		pinnedIndices[minCellValues[index]] = index;
+	}
+	return true;
+}
+
+template <typename Cell>
+SEARCH_KERNEL bool Generator<Cell>::validateSumCheckSegments(vector<Cell>& set, SegmentInfo& segmentInfo, 
+	Sum& currSum) {
 	for (vector<int>& segment : segmentInfo.sumCheckSegments) {
-		int tempSum = originalSum;
+		Sum tempSum = originalSum;
 		for (int& index : segment) {
 			tempSum -= set[index];
 		}
@@ -369,64 +1632,522 @@ bool Generator::validateSumCheckSegments(vector<int>& set, SegmentInfo& segmentI
 	return true;
 }
 
-void Generator::permuteSegment(vector<int> set, SegmentInfo& segmentInfo) {
+template <typename Cell>
+SEARCH_KERNEL void Generator<Cell>::permuteSegment(vector<Cell> set, SegmentInfo& segmentInfo) {
+	int length = segmentInfo.length;
+	if (random != nullptr) {
+		shuffle(set.begin() + segmentInfo.start, set.begin() + segmentInfo.start + length, *random);
+	}
+
+	// Each crossing line only crosses a single cell of the segment, and so whether a value can be placed in a cell is 
+	// independent of the rest of the segment's arrangement. This is worked out up front for every cell and every value 
+	// of the segment (identified by its slot in the unpermuted segment), after which each perm only has to recheck the 
+	// two cells it swapped
+	uint32_t feasibleSlotMasks[maxPermutedSegmentLength];
+	int slots[maxPermutedSegmentLength];
+	int infeasibleCellCount = 0;
+	for (int cell = 0; cell < length; ++cell) {
+		feasibleSlotMasks[cell] = constrainingSearch 
+			? getAllowedSlotMask(set.data() + segmentInfo.start, length, segmentInfo.start + cell) 
+			: (uint32_t(1) << length) - 1;
+		for (CrossingLine& crossingLine : segmentInfo.crossingLines[cell]) {
+			Sum residual = originalSum;
+			for (int index : crossingLine.placedIndices) {
+				residual -= set[index];
+			}
+			for (int slot = 0; slot < length; ++slot) {
+				if (!isSumReachable(crossingLine.remainingCount, residual - set[segmentInfo.start + slot])) {
+					feasibleSlotMasks[cell] &= ~(uint32_t(1) << slot);
+				}
+			}
+		}
+		slots[cell] = cell;
+		infeasibleCellCount += isSlotInfeasible(feasibleSlotMasks, slots, cell);
+	}
+
+	// A uniform sampling dive only takes the random arrangement
+	if (random != nullptr && samplingUniformly) {
+		sampleWeight *= fact(length);
+		if (infeasibleCellCount == 0) {
+			resolveNextSegment(set, segmentInfo);
+		}
+		return;
+	}
+
 	// Feeds the set through as-is, then does every perm of the segment
+	if (infeasibleCellCount == 0) {
+		resolveNextSegment(set, segmentInfo);
+	} else if (walkingPrintOrder) {
+		walkNextSegment(set, segmentInfo);
+	}
+
+	// Heap's algorithm, unrolled into a loop: swapCounts[cell] counts the swaps made into the cell since the cells 
+	// before it were last permuted through completely
+	int swapCounts[maxPermutedSegmentLength] = {};
+	for (int cell2 = 1; cell2 < length;) {
+		// Once a sampled cube is found (or the budget runs out) no further perms are tried, so that it isn't replaced
+		if (counters->nodeCount >= nodeLimit) return;
+
+		if (swapCounts[cell2] == cell2) {
+			swapCounts[cell2] = 0;
+			++cell2;
+			continue;
+		}
+
+		int cell1 = cell2 % 2 == 0 ? 0 : swapCounts[cell2];
+		++swapCounts[cell2];
+		infeasibleCellCount -= isSlotInfeasible(feasibleSlotMasks, slots, cell1) 
+			+ isSlotInfeasible(feasibleSlotMasks, slots, cell2);
+		swap(set[segmentInfo.start + cell1], set[segmentInfo.start + cell2]);
+		swap(slots[cell1], slots[cell2]);
+		infeasibleCellCount += isSlotInfeasible(feasibleSlotMasks, slots, cell1) 
+			+ isSlotInfeasible(feasibleSlotMasks, slots, cell2);
+		if (infeasibleCellCount == 0) {
+			resolveNextSegment(set, segmentInfo);
+		} else if (walkingPrintOrder) {
+			walkNextSegment(set, segmentInfo);
+		}
+		cell2 = 1;
+	}
+}
+
+template <typename Cell>
+template <int length>
+void Generator<Cell>::permuteShortSegment(vector<Cell>& set, SegmentInfo& segmentInfo) {
+	static_assert(length <= maxShortSegmentLength);
+	constexpr int permCount = length == 1 ? 1 : length == 2 ? 2 : 6;
+
+	// Works as permuteSegment() does, but with the loops over the segment unrolled, and with the set permuted in place 
+	// (and then restored) rather than copied
+	Cell* segment = set.data() + segmentInfo.start;
+	Cell values[length];
+	uint32_t feasibleSlotMasks[length];
+	int slots[length];
+	for (int cell = 0; cell < length; ++cell) {
+		values[cell] = segment[cell];
+	}
+	int infeasibleCellCount = 0;
+	for (int cell = 0; cell < length; ++cell) {
+		feasibleSlotMasks[cell] = (uint32_t(1) << length) - 1;
+		for (CrossingLine& crossingLine : segmentInfo.crossingLines[cell]) {
+			Sum residual = originalSum;
+			for (int index : crossingLine.placedIndices) {
+				residual -= set[index];
+			}
+			for (int slot = 0; slot < length; ++slot) {
+				if (!isSumReachable(crossingLine.remainingCount, residual - values[slot])) {
+					feasibleSlotMasks[cell] &= ~(uint32_t(1) << slot);
+				}
+			}
+		}
+
+		// No perm can place any value in a cell with no feasible slots
+		if (feasibleSlotMasks[cell] == 0) return;
+		slots[cell] = cell;
+		infeasibleCellCount += isSlotInfeasible(feasibleSlotMasks, slots, cell);
+	}
+
+	if (infeasibleCellCount == 0) {
+		resolveNextSegment(set, segmentInfo);
+	}
+	for (int i = 0; i < permCount - 1; ++i) {
+		int cell1 = shortSegmentSwaps[i][0];
+		int cell2 = shortSegmentSwaps[i][1];
+		infeasibleCellCount -= isSlotInfeasible(feasibleSlotMasks, slots, cell1) 
+			+ isSlotInfeasible(feasibleSlotMasks, slots, cell2);
+		swap(segment[cell1], segment[cell2]);
+		swap(slots[cell1], slots[cell2]);
+		infeasibleCellCount += isSlotInfeasible(feasibleSlotMasks, slots, cell1) 
+			+ isSlotInfeasible(feasibleSlotMasks, slots, cell2);
+		if (infeasibleCellCount == 0) {
+			resolveNextSegment(set, segmentInfo);
+		}
+	}
+
+	for (int cell = 0; cell < length; ++cell) {
+		segment[cell] = values[cell];
+	}
+}
+
+template <typename Cell>
+SEARCH_KERNEL void Generator<Cell>::resolveNextSegment(vector<Cell>& set, SegmentInfo& segmentInfo) {
 	SegmentInfo* nextSegment = segmentInfo.nextSegment;
-	int newSum = originalSum;
+	if (nextSegment == joinSegment) {
+		if (meetInTheMiddle != nullptr) {
+			meetInTheMiddle->probe(set);
+		} else {
+			frontierFile->addFrame(set.data());
+		}
+		return;
+	}
+
+	Sum newSum = originalSum;
 	for (int& index : nextSegment->sumComplementIndices) {
 		newSum -= set[index];
 	}
-	resolveSegment(set, *nextSegment, nextSegment->start, setSize, setSize, newSum);
+	if (walkingPrintOrder) {
+		resolveSegment(set, *nextSegment, nextSegment->start, setSize, setSize, newSum);
+		return;
+	}
+	if (!nextSegment->isTransposed || !transpositionTable.isEnabled()) {
+		resolveNonAxisSegment(set, *nextSegment, nextSegment->start, 1, newSum);
+		return;
+	}
+
+	TranspositionKey key = getTranspositionKey(set, *nextSegment);
+	unsigned long count;
+	if (transpositionTable.find(key, count)) {
+		counters->cubeIdentityCount += count;
+		++counters->transpositionHitCount;
+		return;
+	}
+	++counters->transpositionMissCount;
+	unsigned long identityCountBefore = counters->cubeIdentityCount;
+	unsigned long nodeCountBefore = counters->nodeCount;
+	resolveNonAxisSegment(set, *nextSegment, nextSegment->start, 1, newSum);
+	transpositionTable.store(key, counters->cubeIdentityCount - identityCountBefore, 
+		counters->nodeCount - nodeCountBefore);
+}
 
-	int swapCount = fact(segmentInfo.length) - 1;
-	for (int i = 0; i < swapCount; ++i) {
-		vector<int>& swapSet = permSwapSets[i];
-		swap(set[segmentInfo.start + swapSet[0]], set[segmentInfo.start + swapSet[1]]);
-		nextSegment = segmentInfo.nextSegment;
-		newSum = originalSum;
-		for (int& index : nextSegment->sumComplementIndices) {
-			newSum -= set[index];
+template <typename Cell>
+TranspositionKey Generator<Cell>::getTranspositionKey(vector<Cell>& set, SegmentInfo& segmentInfo) {
+	// Two independent multiply-xorshift hashes over the segment's start, the availability mask words and the partial 
+	// sums (packed four to a word, or one to a word when they may not fit in 16 bits)
+	uint64_t hash1 = 0x9e3779b97f4a7c15ull ^ segmentInfo.start;
+	uint64_t hash2 = 0xc2b2ae3d27d4eb4full ^ segmentInfo.start;
+	auto mix = [&hash1, &hash2](uint64_t word) {
+		hash1 = (hash1 ^ word) * 0xff51afd7ed558ccdull;
+		hash1 ^= hash1 >> 32;
+		hash2 = (hash2 ^ word) * 0xc4ceb9fe1a85ec53ull;
+		hash2 ^= hash2 >> 29;
+	};
+	for (uint64_t word : availableValueMask) {
+		mix(word);
+	}
+	uint64_t packedSums = 0;
+	int packedCount = 0;
+	int sumsPerWord = originalSum <= UINT16_MAX ? 4 : 1;
+	for (vector<int>& line : segmentInfo.boundaryLines) {
+		uint64_t sum = 0;
+		for (int index : line) {
+			sum += set[index];
+		}
+		packedSums = packedSums << 16 | sum;
+		if (++packedCount == sumsPerWord) {
+			mix(packedSums);
+			packedSums = 0;
+			packedCount = 0;
 		}
-		resolveSegment(set, *nextSegment, nextSegment->start, setSize, setSize, newSum);
 	}
+	mix(packedSums);
+
+	TranspositionKey key;
+	key.hash1 = hash1 ^ hash1 >> 31;
+	key.hash2 = hash2 ^ hash2 >> 31;
+	return key;
+}
+
+template <typename Cell>
+void Generator<Cell>::walkNextSegment(vector<Cell>& set, SegmentInfo& segmentInfo) {
+	walkingOnly = true;
+	resolveNextSegment(set, segmentInfo);
+	walkingOnly = false;
 }
 
-void Generator::print(vector<int>& set) {
-	++cubeIdentityCount;
+template <typename Cell>
+void Generator<Cell>::print(vector<Cell>& set) {
+	if (random != nullptr) {
+		sampledSet = set;
+		nodeLimit = 0;
+		return;
+	}
+
+	++counters->cubeIdentityCount;
 	if (printOption == PrintOption::ALL) {
-		printTransformations(set, dimensionality - 1);
-	} else if (printOption == PrintOption::IDENTITIES) {
-		printCube(set, dimensionality - 1, 0);
+		if (orderedOutput == nullptr) {
+			transformationExpander->submit(set);
+			return;
+		}
+		heldIdentities.insert(heldIdentities.end(), set.begin(), set.end());
+	} else if (printOption == PrintOption::IDENTITIES || printOption == PrintOption::PATHS) {
+		if (printOption == PrintOption::IDENTITIES) {
+			printCube(set, &gatherTables[0], output.getBuffer());
+		} else {
+			printPath(set, output.getBuffer());
+		}
+		if (orderedOutput == nullptr) {
+			output.flushIfFull();
+			return;
+		}
+	} else {
+		return;
+	}
+
+	if (output.getBuffer().size() + heldIdentities.size() * sizeof(Cell) >= maxHeldOutputBytes) {
+		orderedOutput->write(traversedAxisSolidificationSetCount - 1, output.getBuffer(), heldIdentities, false);
 	}
 }
 
-void Generator::printCube(vector<int>& set, int axisIndex, int offset) {
-	// Prints through the current axis
-	for (int i = 0; i < sideLength; ++i) {
-		// If the recursion has reached the foremost axis (the x axis) then it will print that segment, otherwise it 
-		// will add to the offset and recurse
-		int newOffset = offset + dimensionScales[permSegmentSets[interAxisSwapPrintIndex][axisIndex]]
-			* permSegmentSets[intraAxisSwapPrintIndices[axisIndex]][i];
-		if (axisIndex == 0) {
-			ofs << set[convSet[newOffset]] << "\t";
-		} else {
-			printCube(set, axisIndex - 1, newOffset);
+template <typename Cell>
+void Generator<Cell>::appendAxisPath(vector<Cell>& set, string& buffer) {
+	appendSearchPathChoice(buffer, getCanonicalAxisSolidificationSetRank(set));
+
+	// The canonical order has the axis segments ordered by their smallest value, and the values of each ascending
+	vector<Cell> firstValues(dimensionality);
+	for (int axisSegment = 0; axisSegment < dimensionality; ++axisSegment) {
+		SegmentInfo& segmentInfo = solidifiedSegmentInfoSet[axisSegment];
+		firstValues[axisSegment] = *min_element(set.begin() + segmentInfo.start, 
+			set.begin() + segmentInfo.start + segmentInfo.length);
+	}
+	appendSearchPathChoice(buffer, getArrangementRank(firstValues.data(), dimensionality));
+	for (SegmentInfo& segmentInfo : solidifiedSegmentInfoSet) {
+		appendSearchPathChoice(buffer, getArrangementRank(set.data() + segmentInfo.start, segmentInfo.length));
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::printPath(vector<Cell>& set, string& buffer) {
+	buffer += axisPath;
+
+	// Each segment's combination is indexed among those of the values its segments before left available, which the 
+	// availability of the search (all claimed by now) is put aside for
+	vector<uint64_t> searchValueMask = availableValueMask;
+	initialiseAvailableValues(set);
+	for (SegmentInfo& segmentInfo : segmentInfoSet) {
+		Sum currSum = originalSum;
+		for (int index : segmentInfo.sumComplementIndices) {
+			currSum -= set[index];
+		}
+		appendSearchPathChoice(buffer, getCombinationIndex(set, segmentInfo, currSum));
+		appendSearchPathChoice(buffer, getArrangementRank(set.data() + segmentInfo.start, segmentInfo.length));
+		for (int i = segmentInfo.start; i < segmentInfo.start + segmentInfo.length; ++i) {
+			claimValue(set[i]);
 		}
 	}
-	ofs << "\n";
+	availableValueMask = searchValueMask;
 }
 
-void Generator::printTransformations(vector<int>& set, int axisIndex) {
-	// Iterates through intra-axis swaps
-	int& intraAxisSwapIndex = intraAxisSwapPrintIndices[axisIndex];
-	for (intraAxisSwapIndex = 0; intraAxisSwapIndex < fact(sideLength); ++intraAxisSwapIndex) {
-		if (axisIndex == 0) {
-			// Iterates through inter-axis swaps
-			for (interAxisSwapPrintIndex = 0; interAxisSwapPrintIndex < fact(dimensionality); ++interAxisSwapPrintIndex) {
-				printCube(set, dimensionality - 1, 0);
+template <typename Cell>
+unsigned long Generator<Cell>::countCombinations(int count, int minValue, Sum sum) {
+	if (count == 0) return sum == 0;
+
+	// The count values from value on add up to at least count * value + count * (count - 1) / 2
+	unsigned long combinationCount = 0;
+	for (int value = minValue; value <= setSize && Sum(value) * count + count * (count - 1) / 2 <= sum; ++value) {
+		if (isValueAvailable(value)) {
+			combinationCount += countCombinations(count - 1, value + 1, sum - value);
+		}
+	}
+	return combinationCount;
+}
+
+template <typename Cell>
+unsigned long Generator<Cell>::getCombinationIndex(vector<Cell>& set, SegmentInfo& segmentInfo, Sum sum) {
+	vector<Cell> values(set.begin() + segmentInfo.start, set.begin() + segmentInfo.start + segmentInfo.length);
+	sort(values.begin(), values.end());
+
+	// Counts the combinations sharing each prefix of the values, but with a smaller value following it
+	unsigned long index = 0;
+	int minValue = 1;
+	for (int i = 0; i < segmentInfo.length; ++i) {
+		for (int value = minValue; value < values[i]; ++value) {
+			if (isValueAvailable(value)) {
+				index += countCombinations(segmentInfo.length - i - 1, value + 1, sum - value);
 			}
-		} else {
-			printTransformations(set, axisIndex - 1);
 		}
+		sum -= values[i];
+		minValue = values[i] + 1;
+	}
+	return index;
+}
+
+template <typename Cell>
+bool Generator<Cell>::placeCombination(vector<Cell>& set, SegmentInfo& segmentInfo, Sum sum, unsigned long index) {
+	int minValue = 1;
+	for (int i = 0; i < segmentInfo.length; ++i) {
+		int value = minValue;
+		for (; value <= setSize; ++value) {
+			if (!isValueAvailable(value)) continue;
+
+			unsigned long count = countCombinations(segmentInfo.length - i - 1, value + 1, sum - value);
+			if (index < count) break;
+			index -= count;
+		}
+		if (value > setSize) return false;
+
+		set[segmentInfo.start + i] = value;
+		sum -= value;
+		minValue = value + 1;
+	}
+	return true;
+}
+
+template <typename Cell>
+unsigned long Generator<Cell>::getArrangementRank(const Cell* cells, int length) {
+	// Lehmer code: each cell contributes the number of cells after it holding smaller values, in the factorial base
+	unsigned long rank = 0;
+	for (int i = 0; i < length; ++i) {
+		int smallerCount = 0;
+		for (int j = i + 1; j < length; ++j) {
+			smallerCount += cells[j] < cells[i];
+		}
+		rank += smallerCount * fact(length - i - 1);
 	}
+	return rank;
 }
+
+template <typename Cell>
+void Generator<Cell>::arrangeByRank(Cell* cells, int length, unsigned long rank) {
+	vector<Cell> values(cells, cells + length);
+	for (int i = 0; i < length; ++i) {
+		unsigned long blockSize = fact(length - i - 1);
+		auto value = values.begin() + rank / blockSize;
+		rank %= blockSize;
+		cells[i] = *value;
+		values.erase(value);
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::getHeapPerm(unsigned long rank, int length, int* perm) {
+	for (int cell = 0; cell < length; ++cell) {
+		perm[cell] = cell;
+	}
+
+	// The perms of length cells are length blocks of the perms of the first length - 1 cells, each block separated 
+	// from the last by a complete run over those cells and a swap. Skipping whole blocks through heapRunEffects leaves 
+	// the perm at the rank within the block, and so on down
+	vector<int> runPerm(length);
+	for (; length > 1; --length) {
+		unsigned long blockSize = fact(length - 1);
+		unsigned long block = rank / blockSize;
+		rank %= blockSize;
+		for (unsigned long i = 0; i < block; ++i) {
+			for (int cell = 0; cell < length - 1; ++cell) {
+				runPerm[cell] = perm[heapRunEffects[length - 1][cell]];
+			}
+			copy(runPerm.begin(), runPerm.begin() + length - 1, perm);
+			swap(perm[length % 2 == 1 ? 0 : i], perm[length - 1]);
+		}
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::compileTransformation(unsigned long transformation, int* gatherTable) {
+	// Transformations are numbered in the order printTransformations() has always produced them: inter-axis swaps 
+	// innermost, then the intra-axis swaps of each axis from the x axis outwards
+	int interAxisSwapIndex = transformation % fact(dimensionality);
+	transformation /= fact(dimensionality);
+	vector<int> intraAxisSwapIndices(dimensionality);
+	for (int axis = 0; axis < dimensionality; ++axis) {
+		intraAxisSwapIndices[axis] = transformation % fact(sideLength);
+		transformation /= fact(sideLength);
+	}
+
+	vector<int> interAxisPerm(dimensionality);
+	getHeapPerm(interAxisSwapIndex, dimensionality, interAxisPerm.data());
+	vector<int> intraAxisPerms(dimensionality * sideLength);
+	for (int axis = 0; axis < dimensionality; ++axis) {
+		getHeapPerm(intraAxisSwapIndices[axis], sideLength, &intraAxisPerms[axis * sideLength]);
+	}
+
+	// Output positions run through the x axis fastest, and each maps onto the set index of the transformed cell
+	for (int position = 0; position < setSize; ++position) {
+		int offset = 0;
+		for (int axis = 0; axis < dimensionality; ++axis) {
+			int coord = (position / dimensionScales[axis]) % sideLength;
+			offset += dimensionScales[interAxisPerm[axis]] * intraAxisPerms[axis * sideLength + coord];
+		}
+		gatherTable[position] = convSet[offset];
+	}
+}
+
+template <typename Cell>
+void Generator<Cell>::compileTransformations(unsigned long count) {
+	compiledTransformationCount = count;
+	gatherTables.resize(count * setSize);
+	for (unsigned long transformation = 0; transformation < count; ++transformation) {
+		compileTransformation(transformation, &gatherTables[transformation * setSize]);
+	}
+}
+
+template <typename Cell>
+const int* Generator<Cell>::getGatherTable(unsigned long transformation, vector<int>& scratchTable) {
+	if (transformation < compiledTransformationCount) {
+		return &gatherTables[transformation * setSize];
+	}
+	compileTransformation(transformation, scratchTable.data());
+	return scratchTable.data();
+}
+
+template <typename Cell>
+bool Generator<Cell>::openOutput() {
+	if (printOption == PrintOption::PATHS) {
+		if (!output.open("Magic Cubes.paths")) return false;
+		appendSearchPathHeader(output.getBuffer(), sideLength, dimensionality, getPlanHash());
+		return true;
+	}
+	if (!streaming) {
+		return output.open("Magic Cubes.txt");
+	}
+
+	if (!ring.create(streamName, sideLength, dimensionality, streamRingBytes)) {
+		cout << "Unable to create the shared memory ring '" << streamName << "'" << endl;
+		return false;
+	}
+	output.openRing(&ring);
+	return true;
+}
+
+template <typename Cell>
+void Generator<Cell>::printCube(vector<Cell>& set, const int* gatherTable, string& buffer) {
+	if (streaming) {
+		size_t size = buffer.size();
+		buffer.resize(size + setSize * sizeof(int32_t));
+		for (int position = 0; position < setSize; ++position) {
+			int32_t value = set[gatherTable[position]];
+			memcpy(buffer.data() + size + position * sizeof(int32_t), &value, sizeof(int32_t));
+		}
+		return;
+	}
+
+	// Formats straight into the end of the buffer, which is then cut back down to what was written
+	size_t size = buffer.size();
+	buffer.resize(size + maxCubeTextLength);
+	char* out = buffer.data() + size;
+	char* end = buffer.data() + buffer.size();
+	for (int position = 0; position < setSize; ++position) {
+		out = to_chars(out, end, set[gatherTable[position]]).ptr;
+		*out++ = '\t';
+
+		// Ends a line after every full x axis row, and again after every full layer of each further axis
+		for (int scale = sideLength; scale <= setSize && (position + 1) % scale == 0; scale *= sideLength) {
+			*out++ = '\n';
+		}
+	}
+	buffer.resize(out - buffer.data());
+}
+
+template <typename Cell>
+unsigned long Generator<Cell>::printTransformations(vector<Cell>& set, string& buffer, vector<int>& scratchTable) {
+	unsigned long printedCount = 0;
+	for (unsigned long transformation = 0; transformation < transformationCount; ++transformation) {
+		const int* gatherTable = getGatherTable(transformation, scratchTable);
+		if (constrainedPositions.empty() || isCubeAllowed(set, gatherTable)) {
+			printCube(set, gatherTable, buffer);
+			++printedCount;
+		}
+	}
+	return printedCount;
+}
+
+int getCellBits(int sideLength, int dimensionality) {
+	long setSize = 1;
+	for (int i = 0; i < dimensionality && setSize <= UINT16_MAX; ++i) {
+		setSize *= sideLength;
+	}
+	return setSize <= UINT8_MAX ? 8 : setSize <= UINT16_MAX ? 16 : 0;
+}
+
+template class Generator<uint8_t>;
+template class Generator<uint16_t>;
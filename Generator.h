@@ -1,11 +1,34 @@
 #pragma once
 #include <vector>
 #include <chrono>
-#include <fstream>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <climits>
+#include <mutex>
+#include <random>
+#include "AxisSetCache.h"
+#include "SubtreeCache.h"
+#include "OutputWriter.h"
+#include "CubeRing.h"
+#include "Telemetry.h"
+#include "TranspositionTable.h"
 
 using std::vector;
 using std::chrono::high_resolution_clock;
-using std::ofstream;
+using std::string;
+using std::unordered_map;
+using std::unordered_set;
+using std::mutex;
+using std::mt19937_64;
+
+// A line crossing a single cell of a segment, made up of the cells placed before the segment and remainingCount cells 
+// placed after it
+struct CrossingLine {
+	vector<int> placedIndices;
+	int remainingCount;
+};
 
 struct SegmentInfo {
 	int start; // Starting index of the segment within the set 
@@ -13,47 +36,241 @@ struct SegmentInfo {
 	bool isAxisSegment = false;
 	vector<int> sumComplementIndices; // List of indices within set that make up the segment's sum complement
 	vector<vector<int>> sumCheckSegments;
+	vector<vector<CrossingLine>> crossingLines; // For each cell of the segment, the other lines crossing it
+
+	// Lines with cells placed both before and from the start of the segment, as the cells placed before it. Below the 
+	// segment's start, the search depends only on the partial sums of these lines and the values still available
+	vector<vector<int>> boundaryLines;
+	bool isTransposed = false; // Whether counts below the segment's start are kept in the transposition table
 	SegmentInfo* nextSegment;
 };
 
+template <typename Cell> class MeetInTheMiddle;
+template <typename Cell> class TransformationExpander;
+template <typename Cell> class ParallelSearch;
+template <typename Cell> class OrderedOutput;
+class FrontierFile;
+
 enum class PrintOption {
 	ALL,
 	IDENTITIES,
+	PATHS, // Identities as the choices of their search paths (see SearchPathReader)
 	NONE,
 };
 
+// Sums of cell values (line sums, and the residuals of partly filled lines), which are 64 bit so that they can't 
+// overflow however large the cube
+using Sum = int64_t;
+
+/*
+* Magic hypercube search engine, templated on the type of the cells of the search state (the set), which are as 
+* narrow as the cube's values allow so that more of the state fits in each cache line and vector register: uint8_t 
+* when setSize is at most 255, and uint16_t otherwise (see getCellBits()). Both are compiled into Generator.cpp
+*/
+template <typename Cell>
 class Generator {
 	int dimensionality; // The number of dimensions the cube has (2 = square, 3 = cube, 4 = hypercube, etc)
 	int sideLength;
 	int setSize;
 	vector<int> dimensionScales; // Set of values of sidelength^d where d -> [0, dimensionality - 1]
-	int originalSum; // Required sum for a single full segment
+	Sum originalSum; // Required sum for a single full segment
 	int originValue; // The value for the first element of the set (origin point of cube)
 
-	unsigned long cubeIdentityCount = 0;
-	bool calculatingAxisSolidificationSetCount;
+	// Progress of the search, reported while generating (see Telemetry). The search updates its own counters, whose 
+	// nodeCount is the number of calls into resolveNonAxisSegment() (or resolveSegment() in printing runs)
+	Telemetry telemetry;
+	TelemetryCounters* counters;
+	string statsPath;
 	unsigned long totalAxisSolidificationSetCount = 0;
-	unsigned long traversedAxisSolidificationSetCount = 0;
+	unsigned long traversedAxisSolidificationSetCount = 0; // Axis solidification sets walked by printing runs
+	unsigned long firstAxisSolidificationSet = 0; // Range of axis solidification sets being generated
+	unsigned long lastAxisSolidificationSet = ULONG_MAX;
 	high_resolution_clock::time_point startTime;
-	bool generating = false;
 
 	// Printing stuff
 	PrintOption printOption;
-	ofstream ofs;
-	int interAxisSwapPrintIndex = 0;
-	vector<int> intraAxisSwapPrintIndices;
+	OutputWriter output;
+	int maxCubeTextLength; // Longest a cube's text can be (every value as long as setSize, plus separators and line ends)
 
-	vector<int> convSet; // Converts an index from cube coordinates to set coordinates
+	// Cubes are streamed to a consumer process through a shared memory ring of this name (see CubeRing) rather than 
+	// written to the output file, when streaming. Only the primary opens the ring
+	bool streaming = false;
+	string streamName;
+	CubeRing ring;
+
+	// Every transformation printed (each combination of intra-axis swaps of every axis, and inter-axis swap) is 
+	// compiled into a gather table, mapping each output position onto the set index printed there. The first 
+	// compiledTransformationCount tables are held in gatherTables, one after the other
+	unsigned long transformationCount; // sideLength!^dimensionality * dimensionality! (saturating at ULONG_MAX)
+	unsigned long compiledTransformationCount = 0;
+	vector<int> gatherTables;
+	TransformationExpander<Cell>* transformationExpander = nullptr; // Prints every transformation of each identity
 
-	// Set containing all possible permutations of the values -> [0, max(sideLength, dimensionality) - 1]
-	vector<vector<int>> permSegmentSets; 
+	vector<int> convSet; // Converts an index from cube coordinates to set coordinates
 
-	// Set containing the all pairs of indices that when swapped can acheive the segment permutations contained within 
-	// permSegmentSet
-	vector<vector<int>> permSwapSets; 
+	// Perms (of segments, and of the coords and axes of transformations) are generated on the fly by Heap's algorithm 
+	// rather than tabulated. heapRunEffects[length] is the perm a complete run of it over length cells leaves behind, 
+	// cell i then holding the value that started out in cell heapRunEffects[length][i], for length -> [0, 
+	// max(sideLength, dimensionality)]
+	vector<vector<int>> heapRunEffects;
 	vector<SegmentInfo> segmentInfoSet;
 	vector<SegmentInfo> solidifiedSegmentInfoSet;
 
+	vector<vector<int>> lines; // Set indices of every full (sideLength cell) axis-parallel line through the cube
+
+	// Availability state, tracked throughout the search. Together with the values already placed, the values still 
+	// available bound the sums that the unplaced cells of every partially filled line can make up
+	vector<uint64_t> availableValueMask; // Bit (value - 1) is set for every value not yet placed
+
+	// Sums of the n smallest/largest available values for n -> [0, sideLength] (the largest/smallest Sum when fewer 
+	// than n values are available), recalculated on demand whenever availableValueMask no longer matches 
+	// availableSumsMask
+	vector<Sum> minAvailableSums;
+	vector<Sum> maxAvailableSums;
+	vector<uint64_t> availableSumsMask;
+
+	// Set while a segment is only walked for the swaps it makes (see walkNextSegment()), during which completed segments 
+	// are passed over rather than searched beyond
+	bool walkingOnly = false;
+
+	// Axis solidification sets are ranked in a canonical order: the values of each axis segment ascend, and the axis 
+	// segments are ordered by their first value. Cells of the axis segments are numbered in that order as axis cells
+	int axisSegmentLength;
+
+	// Every ascending combination of axisSegmentLength values (other than the origin value) adding up to the sum an 
+	// axis segment requires, ie. every way of filling a single axis segment (its shell partials), in canonical order. 
+	// Each partial is held both as its values (axisSegmentLength of them, in shellPartialValues) and as a value mask 
+	// (availableValueMask.size() words, in shellPartialMasks), so that checking it against the values still available 
+	// takes a few ANDs. Partials are grouped by their first value, firstShellPartials[value] being the first partial 
+	// whose first value is at least value
+	vector<int> shellPartialValues;
+	vector<uint64_t> shellPartialMasks;
+	vector<int> firstShellPartials;
+	int shellPartialCount;
+
+	// Number of ways to complete the axis segments from the start of a given axis segment (see countAxisCompletions()), 
+	// keyed by the first axis cell of the segment, the smallest first value allowed and the available values
+	unordered_map<string, unsigned long> axisCompletionCounts;
+	size_t axisCompletionKeySize;
+
+	// Complete set of axis completion counts shared (read only) by the replicas of a NUMA node, consulted before 
+	// axisCompletionCounts
+	const unordered_map<string, unsigned long>* sharedAxisCompletionCounts = nullptr;
+
+	// Persistent copy of axisCompletionCounts, used in its place when it matches the configuration and plan
+	string axisSetCachePath;
+	AxisSetCache axisSetCache;
+
+	// Per axis solidification set results, reused by count-only runs (or, when verifyingSubtreeCache, checked against 
+	// fresh traversals)
+	string subtreeCachePath;
+	SubtreeCache subtreeCache;
+	bool verifyingSubtreeCache = false;
+
+	// State of the current run, shared by every replica searching for it through primary (and guarded by 
+	// sharedStateMutex once several threads search)
+	bool usingSubtreeCache = false;
+	bool reusingSubtreeResults = false;
+	unsigned long reusedSubtreeCount = 0;
+	unsigned long mismatchedSubtreeCount = 0;
+	unsigned long fruitlessDrawCount = 0; // Sampling draws in a row that found no new cube
+	unsigned long duplicateDrawCount = 0; // Sampling draws in a row that found a cube already drawn
+	mutex sharedStateMutex;
+
+	// Generator whose run this one searches for: itself, or the primary generator of a replica (see ParallelSearch)
+	Generator* primary = this;
+	unsigned threadCount = 1;
+
+	// Parallel search that the axis solidification sets walked by a replica in a printing run are claimed from, by 
+	// their place in the walk (see walkClaimedAxisSolidificationSets())
+	ParallelSearch<Cell>* parallelSearch = nullptr;
+	int parallelWorker = 0;
+
+	// Replicas printing cubes hold the output of the axis solidification set being searched (the text in output's 
+	// buffer, and the identities to expand in heldIdentities), handing it over to orderedOutput so that it is written 
+	// in print order
+	OrderedOutput<Cell>* orderedOutput = nullptr;
+	vector<Cell> heldIdentities;
+
+	// Choices placing the axis solidification set being searched, which the search path of each identity printed 
+	// with PrintOption::PATHS starts with
+	string axisPath;
+
+	// Values each cell may take (by set index), as restricted through addConstraint(). pinnedIndices[value] is the set 
+	// index of the cell the value is pinned to (-1 if none), which no other cell may then take. constrainedPositions 
+	// holds the output positions of the restricted cells
+	vector<int> minCellValues;
+	vector<int> maxCellValues;
+	vector<int> pinnedIndices;
+	vector<int> constrainedPositions;
+
+	// Whether the search only places values where the constraints allow (so that only identities whose printed 
+	// arrangement matches are found), rather than every transformation printed being filtered (PrintOption::ALL, where 
+	// any identity may have transformations that match)
+	bool constrainingSearch = false;
+
+	// Whether the search walks the axis solidification sets in print order (see walkAxisSolidificationSets()) rather 
+	// than placing each from its rank: when printing, and when constraining the search, since the constraints apply to 
+	// the arrangement each identity is printed in
+	bool walkingPrintOrder = false;
+
+	// Cube identity counts below the starts of the transposed segments, kept (in count-only searches) so that states 
+	// reached again along other paths are counted without being searched
+	TranspositionTable transpositionTable;
+	size_t transpositionTableSize = 0;
+
+	// Sampling state (see generateSample()). While random is set, the search walks candidates and perms in a random 
+	// order, gives up once nodeLimit nodes have been searched, and stops at the first cube found, keeping it in 
+	// sampledSet. Sampling uniformly, it instead follows a single random path, multiplying sampleWeight by the number of 
+	// choices at each step
+	mt19937_64* random = nullptr;
+	bool samplingUniformly = false;
+	double sampleWeight = 0;
+	unsigned long nodeLimit = ULONG_MAX;
+	vector<Cell> sampledSet;
+
+	// When set, the search stops at joinSegment and hands the partial set over to the meet-in-the-middle join (or, 
+	// building a frontier, appends it to frontierFile as a frame) instead of resolving the remaining segments itself
+	MeetInTheMiddle<Cell>* meetInTheMiddle = nullptr;
+	FrontierFile* frontierFile = nullptr;
+	SegmentInfo* joinSegment = nullptr;
+
+	/*
+	* Replicates the primary generator for a thread of a parallel search. The segment plan is rebuilt, so that (when 
+	* called on a pinned thread) the plan and the search state are allocated on the thread's own NUMA node. Axis 
+	* completion counts come from the axis set cache file when the primary has it mapped, and otherwise from 
+	* sharedAxisCompletionCounts (a complete copy of the primary's, local to the node). Counters, the subtree cache 
+	* and output are those of the primary
+	*/
+	Generator(Generator& primary, const unordered_map<string, unsigned long>* sharedAxisCompletionCounts);
+
+	// Hash of the segment plan (everything the axis solidification sets and the search over them depend on)
+	uint64_t getPlanHash();
+
+	// Generates the shell partials (on first use, as there are far too many to list for the larger cubes whose search 
+	// could never be run anyway)
+	void generateShellPartials();
+
+	// Returns the first shell partial from partial on whose values are all available (shellPartialCount if there are 
+	// none), skipping over whole groups whose first value is taken
+	int findAvailableShellPartial(int partial);
+
+	// Flags the values of the shell partial as no longer/again available
+	void claimShellPartial(int partial);
+	void releaseShellPartial(int partial);
+
+	/*
+	* Counts the ways of completing the axis segments from axisSegment on, with the values currently available, given 
+	* that the segment's first value is at least minValue. Each segment is filled by joining an available shell partial 
+	* onto the ones chosen for the segments before it. Results are memoised in axisCompletionCounts (or read from 
+	* axisSetCache)
+	*/
+	unsigned long countAxisCompletions(int axisSegment, int minValue);
+
+	// Counts the ways of completing the axis segments after filling axisSegment with the shell partial (whose values 
+	// must be available)
+	unsigned long countAxisCompletionsWithPartial(int axisSegment, int partial);
+
 	/*
 	* Recursively resolves each element in the current segment (recursion transition A), and then calls into the next 
 	* task function. Axis segments are first, and so having completed an axis segment this function will call itself 
@@ -66,28 +283,281 @@ class Generator {
 	* the current segment. segmentExemptPos has a similar purpose, but effectively only applies to the first element of 
 	* each axis segment, to ensure the same combinations of segments aren't generated multiple times in different orders
 	* during axis solidification
+	* 
+	* This is the search of printing runs, whose axis solidification sets are walked in the order their cubes are 
+	* printed in. That order depends on the swaps made walking the sets before, and so the sets before 
+	* firstAxisSolidificationSet are walked through without being searched beyond
 	*/
-	void resolveSegment(vector<int>& set, SegmentInfo& segmentInfo, int depth, int exemptPos, int segmentExemptPos, 
-		int currSum);
+	void resolveSegment(vector<Cell>& set, SegmentInfo& segmentInfo, int depth, int exemptPos, int segmentExemptPos, 
+		Sum currSum);
+
+	// Moves on from the last axis segment of the set to the first non-axis segment (recursion transition C)
+	void resolveAxisSolidificationSet(vector<Cell>& set);
+
+	// Walks the axis solidification sets from the beginning, in the order their cubes are printed in,
+	// searching those from firstAxisSolidificationSet until the walk reaches lastAxisSolidificationSet
+	void walkAxisSolidificationSets();
+
+	/*
+	* Searches the axis solidification sets a replica claims from parallelSearch in a run walking the print order, which 
+	* are claimed by their place in that order. Each set is reached by walking on from the set searched before it, and 
+	* a claim behind the walk (one stolen from a range lower down) restarts the walk from the beginning
+	*/
+	void walkClaimedAxisSolidificationSets();
+
+	// Hands the output of the axis solidification set just searched over to orderedOutput, then claims the next set 
+	// for the walk of a replica, stopping the walk if there are none left or if the walk has already passed it
+	void claimNextWalkedAxisSolidificationSet();
+
+	// Rank within the canonical order of the axis solidification set placed in the set in any arrangement
+	unsigned long getCanonicalAxisSolidificationSetRank(vector<Cell>& set);
+
+	// Records the results of the subtree of the axis solidification set at the rank, which was traversed from 
+	// subtreeStartTime on, starting from the given counts. Also reports the subtree if its recorded result differs
+	void recordSubtreeResult(unsigned long rank, unsigned long identityCountBefore, unsigned long nodeCountBefore, 
+		high_resolution_clock::time_point subtreeStartTime);
+
+	/*
+	* Count-only alternative to resolveSegment() for non-axis segments, which chooses the segment's values as an 
+	* ascending combination of the available values (each at least minValue) that sums to currSum. As the candidates 
+	* are walked in ascending order, the loop stops at the first value too large for the remaining cells to still fit 
+	* under currSum, and skips values too small for them to still reach it. The last cell is looked up directly. Having 
+	* resolved a non-axis segment, if it was the last segment in the set then it will call print(), otherwise it will 
+	* call into permuteSegment(). Printing runs keep resolveSegment(), as the order its swaps leave the unplaced values 
+	* in is the order the cubes are printed in
+	*/
+	void resolveNonAxisSegment(vector<Cell>& set, SegmentInfo& segmentInfo, int depth, int minValue, Sum currSum);
+
+	// Works out the range of values [lowValue, highValue] the next of remainingCount ascending values adding up to 
+	// currSum may take, given that it is at least minValue
+	void getCandidateBounds(int remainingCount, int minValue, Sum currSum, int& lowValue, int& highValue);
+
+	// Resolves the cell at depth of a non-axis segment while sampling, trying the available values of [lowValue, 
+	// highValue] in a random order (or only one of them, sampling uniformly)
+	void sampleCandidates(vector<Cell>& set, SegmentInfo& segmentInfo, int depth, int lowValue, int highValue, 
+		Sum currSum);
+
+	// Claims chunks of the frontier file and searches the frames of each on a thread of searchFrontier(), recording the 
+	// cube identity count of each chunk in the file, and adding the number of chunks searched to searchedChunkCount
+	void searchFrontierChunks(const string& path, unsigned long& searchedChunkCount);
+
+	// Dives into random axis solidification sets on a thread of generateSample() until sampleCount distinct cubes have 
+	// been found between every thread, writing a random transformation of each cube found
+	void sampleCubes(uint64_t seed, unsigned long sampleCount, unordered_set<string>& samples);
+
+	// Appends the choices placing the axis solidification set of the set to the buffer (see SearchPathReader)
+	void appendAxisPath(vector<Cell>& set, string& buffer);
+
+	// Appends the search path of the identity in the set to the buffer, following on from axisPath
+	void printPath(vector<Cell>& set, string& buffer);
+
+	// Number of ascending combinations of count available values, each at least minValue, that add up to sum
+	unsigned long countCombinations(int count, int minValue, Sum sum);
+
+	// Index of the combination of values in the segment (in any arrangement) among the ascending combinations of the 
+	// available values that add up to sum, and its inverse, which places that combination in ascending order (returning 
+	// false if the index is out of range)
+	unsigned long getCombinationIndex(vector<Cell>& set, SegmentInfo& segmentInfo, Sum sum);
+	bool placeCombination(vector<Cell>& set, SegmentInfo& segmentInfo, Sum sum, unsigned long index);
+
+	// Index of the arrangement of the cells among the perms of their values in lexicographic order, and its inverse, 
+	// which arranges cells holding their values in ascending order into the perm of that index
+	unsigned long getArrangementRank(const Cell* cells, int length);
+	void arrangeByRank(Cell* cells, int length, unsigned long rank);
+
+	// Resets the availability state to only the origin value being placed
+	void resetAvailableValues();
+
+	// Resets the availability state to the set having all of its axis segments (and nothing else) placed
+	void initialiseAvailableValues(vector<Cell>& set);
+
+	// Flags the value as no longer/again available
+	void claimValue(int value);
+	void releaseValue(int value);
+	bool isValueAvailable(int value);
+	int getFirstAvailableValue();
+
+	// Checks that the residual lies between the smallest and largest sums remainingCount available values could make
+	bool isSumReachable(int remainingCount, Sum residual);
+	void updateAvailableSums();
 
 	// Ensures that the currSum matches the value that would be created by the segment's sum check segments 
 	// (where necessary)
-	bool validateSumCheckSegments(vector<int>& set, SegmentInfo& segmentInfo, int& currSum);
+	bool validateSumCheckSegments(vector<Cell>& set, SegmentInfo& segmentInfo, Sum& currSum);
+
+	// Whether the constraints allow the value in the cell at the set index
+	bool isValueAllowed(int index, int value);
+
+	// Whether the constraints allow the values of the set in each cell of [start, start + length)
+	bool areValuesAllowed(vector<Cell>& set, int start, int length);
 
-	// Iterates through every permutation of the current segment, calling into resolveSegment() for every permutation 
-	// generated
-	void permuteSegment(vector<int> set, SegmentInfo& segmentInfo);
+	// Mask of the slots of the segment's values (length of them) that the constraints allow in the cell at the set index
+	uint32_t getAllowedSlotMask(const Cell* values, int length, int index);
+
+	// Whether the transformation of the set given by the gather table matches the constraints
+	bool isCubeAllowed(vector<Cell>& set, const int* gatherTable);
+
+	// Iterates through every permutation of the current segment (whose values have been claimed), calling into 
+	// resolveNextSegment() for every permutation generated that leaves every line crossing the segment completable
+	void permuteSegment(vector<Cell> set, SegmentInfo& segmentInfo);
+
+	// Specialisation of permuteSegment() for segments of a length known at compile time (up to maxShortSegmentLength), 
+	// which permutes the set in place rather than permuting a copy of it. Only count-only runs use it, as printing 
+	// runs rely on each perm's walk leaving the copy rearranged for the next. Only the permutation is specialised, as 
+	// choosing a short segment's combination already comes down to a bound check and a mask lookup per cell (see 
+	// resolveNonAxisSegment()), and its sum checks run over lines as long as the side rather than the segment, so 
+	// neither would unroll any further for a known segment length
+	template <int length>
+	void permuteShortSegment(vector<Cell>& set, SegmentInfo& segmentInfo);
+
+	// Fingerprint of the search state at the start of the segment: the segment, the available values and the partial 
+	// sums of its boundary lines
+	TranspositionKey getTranspositionKey(vector<Cell>& set, SegmentInfo& segmentInfo);
+
+	// Calculates the sum required by the segment following segmentInfo and calls into resolveNonAxisSegment() (count-only 
+	// runs) or resolveSegment() (printing runs) for it, or into the meet-in-the-middle join if that segment is the join 
+	// segment
+	void resolveNextSegment(vector<Cell>& set, SegmentInfo& segmentInfo);
+
+	// Walks the segment following segmentInfo without searching beyond it, for perms that can't be completed. The perms 
+	// of a segment share a single set, which each perm's walk leaves rearranged for the next, and so printing runs 
+	// still walk pruned perms to print cubes in the same order as without pruning
+	void walkNextSegment(vector<Cell>& set, SegmentInfo& segmentInfo);
+
+	// Places the axis solidification set of the rank into the set, and traverses its subtree (or reuses the result 
+	// recorded for it in the subtree cache)
+	void traverseAxisSolidificationSet(unsigned long rank, vector<Cell>& set);
 
 	// Simple interface point for performing the correct printing logic based on the value of printOption
-	void print(vector<int>& set);
+	void print(vector<Cell>& set);
+
+	// Writes the perm of length cells at the rank within the order Heap's algorithm generates them in into perm, each 
+	// cell holding the cell it is taken from
+	void getHeapPerm(unsigned long rank, int length, int* perm);
+
+	// Writes the gather table of the transformation (numbered in print order) into gatherTable
+	void compileTransformation(unsigned long transformation, int* gatherTable);
+
+	// Compiles the first count transformations into gatherTables
+	void compileTransformations(unsigned long count);
+
+	// Returns the transformation's gather table, compiling it into scratchTable (setSize entries) if it isn't held
+	const int* getGatherTable(unsigned long transformation, vector<int>& scratchTable);
+
+	// Opens the output file, or creates the ring when streaming, returning false if it couldn't be
+	bool openOutput();
+
+	// Appends the elements of the set to the buffer in the correct format (as a binary record when streaming), in the 
+	// order given by the gather table
+	void printCube(vector<Cell>& set, const int* gatherTable, string& buffer);
 
-	// Recursively propegates through the cube and prints its elements to a file in the correct format
-	void printCube(vector<int>& set, int axisIndex, int offset);
+	// Appends every transformation of the set matching the constraints to the buffer, returning how many were appended
+	unsigned long printTransformations(vector<Cell>& set, string& buffer, vector<int>& scratchTable);
 
-	// Recursively performs intra/inter-axis swap logic and then delegates to printCube
-	void printTransformations(vector<int>& set, int axisIndex);
+	friend class MeetInTheMiddle<Cell>;
+	friend class TransformationExpander<Cell>;
+	friend class ParallelSearch<Cell>;
 
 public:
 	Generator(int sideLength, int dimensionality);
-	void generate(PrintOption printOption);
+
+	/*
+	* Generates every cube whose axis solidification set lies in [firstAxisSolidificationSet, 
+	* firstAxisSolidificationSet + axisSolidificationSetCount). Count-only runs place each of those sets directly from 
+	* its rank in the canonical order, whereas printing runs take them in the order their cubes are printed in, so that 
+	* the output of consecutive ranges adds up to the output of a whole run. Returns false if the output couldn't be 
+	* written
+	*/
+	bool generate(PrintOption printOption, unsigned long firstAxisSolidificationSet = 0, 
+		unsigned long axisSolidificationSetCount = ULONG_MAX);
+
+	// Counts the axis solidification sets, reading the counts from the axis set cache file if it matches, and writing 
+	// them to it otherwise
+	unsigned long countAxisSolidificationSets();
+
+	// Path of the axis set cache file (an empty path disables it)
+	void setAxisSetCachePath(const string& path);
+
+	// Path of the subtree result database (an empty path disables it)
+	void setSubtreeCachePath(const string& path);
+
+	// Path of the stats file rewritten while generating (an empty path disables it)
+	void setStatsPath(const string& path);
+
+	// Traverses every axis solidification set even when counting, reporting any whose result differs from the one 
+	// recorded in the subtree result database
+	void setVerifyingSubtreeCache(bool verifying);
+
+	// Memory given to the transposition table used by count-only searches, split between the search threads (0 
+	// disables it)
+	void setTranspositionTableSize(size_t bytes);
+
+	// Streams the cubes (as binary records, in the order they would be printed) to a consumer process through the 
+	// shared memory ring of this name, instead of writing them to the output file. An empty name disables streaming
+	void setStreamName(const string& name);
+
+	// Number of threads searching the axis solidification sets (see ParallelSearch). The meet-in-the-middle engine 
+	// always searches on a single thread
+	void setThreadCount(unsigned count);
+
+	/*
+	* Restricts the cell at the cube coordinates (one per axis, the x axis first, as printed) to values in [minValue, 
+	* maxValue], or pins it to a single value when they are equal. Restrictions of the same cell intersect. Identity 
+	* searches only place values where the constraints allow, and so only find the identities matching in the 
+	* arrangement they are printed in, whereas with PrintOption::ALL every identity is searched and only the 
+	* transformations matching are printed. Constraints are 
+	* not applied by the meet-in-the-middle engine. Returns false (leaving the constraints unchanged) if the coordinates 
+	* or values are out of range
+	*/
+	bool addConstraint(const vector<int>& coords, int minValue, int maxValue);
+
+	// Places the axis solidification set at the rank within the canonical order into the set (along with the origin 
+	// value), leaving its values claimed, without traversing the sets before it
+	void unrankAxisSolidificationSet(unsigned long rank, vector<Cell>& set);
+
+	// Inverse of unrankAxisSolidificationSet(), giving the rank of the axis solidification set placed in the set
+	unsigned long rankAxisSolidificationSet(vector<Cell>& set);
+
+	/*
+	* Writes sampleCount distinct cubes drawn at random (rather than every cube) to the output file, searching on every 
+	* thread (see setThreadCount()). Each draw searches a random axis solidification set, walking the candidates in a 
+	* random order and restarting elsewhere if no cube turns up quickly, and writes a random transformation of the 
+	* first cube found (one matching the constraints, if any). That favours cubes with few siblings, so when uniform 
+	* is set each draw instead follows a single random path, and the cube it reaches is accepted with a probability in 
+	* proportion to the number of paths like it, making every cube roughly equally likely (at the cost of far more 
+	* draws). Draws are reproducible from the seed when run on a single thread. Sampling stops early once draws keep 
+	* finding cubes already drawn (or none at all), as happens when fewer cubes exist than were asked for. Returns 
+	* false if the output couldn't be written
+	*/
+	bool generateSample(unsigned long sampleCount, uint64_t seed, bool uniform);
+
+	// Rebuilds the cube identities from the search path file at the path (written by PrintOption::PATHS for the same 
+	// configuration and segment plan), writing them to the output exactly as PrintOption::IDENTITIES would have. 
+	// Returns false if the file doesn't match, is corrupt, or the output couldn't be written
+	bool decodePaths(const string& path);
+
+	/*
+	* First phase of an out-of-core count, which expands the search of the axis solidification sets in 
+	* [firstAxisSolidificationSet, firstAxisSolidificationSet + axisSolidificationSetCount) as far as the start of the 
+	* non-axis segment at depth (0 for the axis solidification sets themselves), writing the partial set reached at 
+	* each point as a frame of the frontier file at path (see FrontierFile), in chunks of framesPerChunk frames. 
+	* Returns false if the file couldn't be written
+	*/
+	bool buildFrontier(const string& path, int depth, unsigned framesPerChunk, unsigned long firstAxisSolidificationSet 
+		= 0, unsigned long axisSolidificationSetCount = ULONG_MAX);
+
+	// Second phase of an out-of-core count, which searches the chunks of the frontier file at path not yet searched (on 
+	// every thread given by setThreadCount()) alongside any other processes doing the same, and reports the cube 
+	// identity count once every chunk has been searched. Returns false if the file doesn't match the configuration 
+	// and plan
+	bool searchFrontier(const string& path);
+
+	// Count-only alternative to generate(), which splits the segment plan at the non-axis segment splitSegmentIndex and 
+	// joins the two halves through a hash table (see MeetInTheMiddle). A splitSegmentIndex of 0 picks a default split. 
+	// Returns false if the output couldn't be written
+	bool generateMeetInTheMiddle(int splitSegmentIndex, size_t memoryLimit);
 };
+
+// Width in bits of the cells of a sideLength^dimensionality cube's search state (8 or 16, the Cell type the Generator 
+// is instantiated with), or 0 if its values are too large for any of them
+int getCellBits(int sideLength, int dimensionality);
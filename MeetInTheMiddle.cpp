@@ -0,0 +1,236 @@
+#include "MeetInTheMiddle.h"
+#include "Generator.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <unistd.h>
+
+using namespace std;
+
+// Number of partition files each table is spread across once spilled
+const int partitionCount = 64;
+
+// Rough per entry overhead of an unordered_map<string, unsigned long> node, on top of the signature's own bytes
+const size_t tableEntryOverhead = 64;
+
+template <typename Cell>
+MeetInTheMiddle<Cell>::MeetInTheMiddle(Generator<Cell>& _generator, int _splitStart, size_t _memoryLimit)
+	: generator(_generator) {
+	setSize = generator.setSize;
+	splitStart = _splitStart;
+	memoryLimit = _memoryLimit;
+	maskWordCount = (setSize + 63) / 64;
+	used = vector<bool>(setSize + 1, false);
+	values.resize(setSize);
+	positionLines.resize(setSize);
+
+	int sideLength = generator.sideLength;
+	Sum originalSum = generator.originalSum;
+	for (size_t i = 0; i < generator.lines.size(); ++i) {
+		vector<int>& line = generator.lines[i];
+		int firstHalfCellCount = count_if(line.begin(), line.end(), [this](int index) { return index < splitStart; });
+		if (firstHalfCellCount == sideLength) continue;
+
+		// The first half contributes at least the sum of the smallest values, and at most the sum of the largest values
+		Sum minFirstHalfSum = 0;
+		Sum maxFirstHalfSum = 0;
+		for (int j = 0; j < firstHalfCellCount; ++j) {
+			minFirstHalfSum += j + 1;
+			maxFirstHalfSum += setSize - j;
+		}
+
+		int slot = lineSums.size();
+		lineSums.push_back(0);
+		lineMinSums.push_back(originalSum - maxFirstHalfSum);
+		lineMaxSums.push_back(originalSum - minFirstHalfSum);
+		lineLastPositions.push_back(*max_element(line.begin(), line.end()));
+		for (int index : line) {
+			if (index >= splitStart) positionLines[index].push_back(slot);
+		}
+		if (firstHalfCellCount > 0) {
+			openLines.push_back(i);
+			openLineSlots.push_back(slot);
+		}
+	}
+
+	spillDirectory = (filesystem::temp_directory_path() / ("magicHyperCubeJoin" + to_string(getpid()))).string();
+}
+
+template <typename Cell>
+MeetInTheMiddle<Cell>::~MeetInTheMiddle() {
+	if (spilled) {
+		filesystem::remove_all(spillDirectory);
+	}
+}
+
+template <typename Cell>
+void MeetInTheMiddle<Cell>::enumerateSecondHalf() {
+	enumerateSecondHalf(splitStart);
+	if (spilled) {
+		spill(buildTable, buildTableBytes, "build");
+	}
+}
+
+template <typename Cell>
+void MeetInTheMiddle<Cell>::enumerateSecondHalf(int position) {
+	if (position == setSize) {
+		vector<Sum> sums;
+		for (int slot : openLineSlots) {
+			sums.push_back(lineSums[slot]);
+		}
+		string signature = createSignature(values, splitStart, setSize, sums);
+		++buildSignatureCount;
+		record(buildTable, buildTableBytes, "build", signature, 1);
+		return;
+	}
+
+	vector<int>& slots = positionLines[position];
+	for (int value = 1; value <= setSize; ++value) {
+		if (used[value]) continue;
+
+		// Every line crossing the position must still be able to reach a sum that the first half can complete
+		bool valid = true;
+		for (int slot : slots) {
+			lineSums[slot] += value;
+			if (lineSums[slot] > lineMaxSums[slot]
+				|| (lineLastPositions[slot] == position && lineSums[slot] < lineMinSums[slot])) {
+				valid = false;
+			}
+		}
+		if (valid) {
+			used[value] = true;
+			values[position] = value;
+			enumerateSecondHalf(position + 1);
+			used[value] = false;
+		}
+		for (int slot : slots) {
+			lineSums[slot] -= value;
+		}
+	}
+}
+
+template <typename Cell>
+void MeetInTheMiddle<Cell>::probe(vector<Cell>& set) {
+	Sum originalSum = generator.originalSum;
+	vector<Sum> sums;
+	for (int line : openLines) {
+		Sum sum = originalSum;
+		for (int index : generator.lines[line]) {
+			if (index < splitStart) sum -= set[index];
+		}
+		sums.push_back(sum);
+	}
+
+	// The second half has to use exactly the values the first half doesn't
+	string signature = createSignature(set, 0, splitStart, sums);
+	uint64_t* mask = reinterpret_cast<uint64_t*>(signature.data());
+	for (int value = 1; value <= setSize; ++value) {
+		mask[(value - 1) / 64] ^= uint64_t(1) << ((value - 1) % 64);
+	}
+
+	if (spilled) {
+		record(probeTable, probeTableBytes, "probe", signature, 1);
+	} else {
+		auto iter = buildTable.find(signature);
+		if (iter != buildTable.end()) {
+			matchCount += iter->second;
+		}
+	}
+}
+
+template <typename Cell>
+unsigned long MeetInTheMiddle<Cell>::finish() {
+	if (!spilled) return matchCount;
+
+	spill(probeTable, probeTableBytes, "probe");
+	cout << "Joining spilled partitions..." << endl;
+
+	auto readRecord = [](ifstream& ifs, string& signature, unsigned long& count) {
+		uint32_t length;
+		if (!ifs.read(reinterpret_cast<char*>(&length), sizeof(length))) return false;
+		signature.resize(length);
+		ifs.read(signature.data(), length);
+		ifs.read(reinterpret_cast<char*>(&count), sizeof(count));
+		return bool(ifs);
+	};
+
+	for (int partition = 0; partition < partitionCount; ++partition) {
+		unordered_map<string, unsigned long> table;
+		string signature;
+		unsigned long count;
+		ifstream buildIfs(getPartitionPath("build", partition), ios::binary);
+		while (readRecord(buildIfs, signature, count)) {
+			table[signature] += count;
+		}
+		ifstream probeIfs(getPartitionPath("probe", partition), ios::binary);
+		while (readRecord(probeIfs, signature, count)) {
+			auto iter = table.find(signature);
+			if (iter != table.end()) {
+				matchCount += iter->second * count;
+			}
+		}
+	}
+	return matchCount;
+}
+
+template <typename Cell>
+unsigned long MeetInTheMiddle<Cell>::getSecondHalfSignatureCount() {
+	return buildSignatureCount;
+}
+
+template <typename Cell>
+string MeetInTheMiddle<Cell>::createSignature(vector<Cell>& values, int begin, int end, vector<Sum>& sums) {
+	string signature(maskWordCount * sizeof(uint64_t) + sums.size() * sizeof(int32_t), '\0');
+	uint64_t* mask = reinterpret_cast<uint64_t*>(signature.data());
+	for (int i = begin; i < end; ++i) {
+		mask[(values[i] - 1) / 64] |= uint64_t(1) << ((values[i] - 1) % 64);
+	}
+	copy(sums.begin(), sums.end(), reinterpret_cast<int32_t*>(mask + maskWordCount));
+	return signature;
+}
+
+template <typename Cell>
+void MeetInTheMiddle<Cell>::record(unordered_map<string, unsigned long>& table, size_t& tableBytes, 
+	const string& prefix, const string& signature, unsigned long count) {
+	auto [iter, inserted] = table.try_emplace(signature, 0);
+	iter->second += count;
+	if (inserted) {
+		tableBytes += signature.size() + tableEntryOverhead;
+		if (tableBytes > memoryLimit) {
+			if (!spilled) {
+				cout << "Signature table exceeded the memory limit, spilling to " << spillDirectory << endl;
+				filesystem::create_directories(spillDirectory);
+				spilled = true;
+			}
+			spill(table, tableBytes, prefix);
+		}
+	}
+}
+
+template <typename Cell>
+void MeetInTheMiddle<Cell>::spill(unordered_map<string, unsigned long>& table, size_t& tableBytes, 
+	const string& prefix) {
+	vector<ofstream> partitions;
+	for (int partition = 0; partition < partitionCount; ++partition) {
+		partitions.emplace_back(getPartitionPath(prefix, partition), ios::binary | ios::app);
+	}
+	for (auto& [signature, count] : table) {
+		ofstream& ofs = partitions[hash<string>()(signature) % partitionCount];
+		uint32_t length = signature.size();
+		ofs.write(reinterpret_cast<const char*>(&length), sizeof(length));
+		ofs.write(signature.data(), length);
+		ofs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+	}
+	table.clear();
+	tableBytes = 0;
+}
+
+template <typename Cell>
+string MeetInTheMiddle<Cell>::getPartitionPath(const string& prefix, int partition) {
+	return spillDirectory + "/" + prefix + to_string(partition) + ".bin";
+}
+
+template class MeetInTheMiddle<uint8_t>;
+template class MeetInTheMiddle<uint16_t>;
@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+using std::vector;
+using std::string;
+using std::unordered_map;
+
+template <typename Cell> class Generator;
+using Sum = int64_t;
+
+/*
+* Count-only meet-in-the-middle join over the segment plan. The set is split at splitStart: the first half
+* ([0, splitStart)) is enumerated by the generator's own search, which hands every partial set over to probe(), while
+* the second half ([splitStart, setSize)) is enumerated independently by enumerateSecondHalf().
+*
+* Both halves are reduced to a boundary signature made up of the mask of values the second half uses, and the sum that
+* the second half contributes to every open line (lines with cells in both halves). A first half and a second half
+* combine into a valid cube exactly when their signatures are equal, so the number of cubes is the sum over all
+* signatures of the product of the two halves' counts.
+*
+* The second half is indexed in a hash table. If that table grows beyond memoryLimit, it is spilled to partition
+* files on disk (as are the first half's signatures from then on), and the join is completed partition by partition
+* in finish()
+*/
+template <typename Cell>
+class MeetInTheMiddle {
+	Generator<Cell>& generator;
+	int setSize;
+	int splitStart; // First set index belonging to the second half
+	size_t memoryLimit; // Approximate number of bytes the in-memory signature tables are allowed to occupy
+
+	vector<int> openLines; // Indices within generator.lines of lines that have cells in both halves
+	int maskWordCount;
+
+	// Second half enumeration state. Each line touching the second half has an entry in lineSums, and every second half
+	// set index has the list of those lines that cross it
+	vector<vector<int>> positionLines;
+	vector<Sum> lineSums;
+	vector<Sum> lineMinSums; // Smallest sum the second half may contribute to the line
+	vector<Sum> lineMaxSums; // Largest sum the second half may contribute to the line
+	vector<int> lineLastPositions; // Last second half set index that the line crosses
+	vector<int> openLineSlots; // lineSums entries of the open lines, in the same order as openLines
+	vector<Cell> values; // Second half values, indexed by set index
+	vector<bool> used;
+
+	// Signature -> count tables for the second half (build side) and, once spilled, the first half (probe side)
+	unordered_map<string, unsigned long> buildTable;
+	unordered_map<string, unsigned long> probeTable;
+	size_t buildTableBytes = 0;
+	size_t probeTableBytes = 0;
+	unsigned long buildSignatureCount = 0;
+	bool spilled = false;
+	string spillDirectory;
+
+	unsigned long matchCount = 0;
+
+	// Creates the signature of the values placed in the set range [begin, end), and the line sums given by sums (held 
+	// as 32 bits each, as no line of a cube whose values fit in the cells can sum to more)
+	string createSignature(vector<Cell>& values, int begin, int end, vector<Sum>& sums);
+
+	void enumerateSecondHalf(int position);
+
+	// Adds count to the signature's entry in the table, spilling the table to disk once it exceeds the memory limit
+	void record(unordered_map<string, unsigned long>& table, size_t& tableBytes, const string& prefix,
+		const string& signature, unsigned long count);
+
+	// Appends every entry of the table to its partition file, and then clears the table
+	void spill(unordered_map<string, unsigned long>& table, size_t& tableBytes, const string& prefix);
+
+	string getPartitionPath(const string& prefix, int partition);
+
+public:
+	MeetInTheMiddle(Generator<Cell>& generator, int splitStart, size_t memoryLimit);
+	~MeetInTheMiddle();
+
+	// Enumerates every filling of the second half and indexes it by signature
+	void enumerateSecondHalf();
+
+	// Joins the first half contained in the set against the second half table
+	void probe(vector<Cell>& set);
+
+	// Completes any join work left on disk, and returns the total number of cubes joined
+	unsigned long finish();
+
+	unsigned long getSecondHalfSignatureCount();
+};
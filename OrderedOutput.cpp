@@ -0,0 +1,86 @@
+#include "OrderedOutput.h"
+#include "OutputWriter.h"
+#include "TransformationExpander.h"
+
+using namespace std;
+
+template <typename Cell>
+OrderedOutput<Cell>::OrderedOutput(OutputWriter& _output, TransformationExpander<Cell>* _expander, int _setSize,
+	unsigned long firstRank, size_t _maxParkedBytes) : output(_output) {
+	expander = _expander;
+	setSize = _setSize;
+	nextRank = firstRank;
+	maxParkedBytes = _maxParkedBytes;
+}
+
+template <typename Cell>
+void OrderedOutput<Cell>::write(unsigned long rank, string& text, vector<Cell>& identities, bool complete) {
+	unique_lock<mutex> lock(stateMutex);
+	if (rank != nextRank) {
+		ParkedOutput& parkedOutput = parked[rank];
+		parkedOutput.text += text;
+		parkedOutput.identities.insert(parkedOutput.identities.end(), identities.begin(), identities.end());
+		parkedOutput.complete = complete;
+		parkedBytes += text.size() + identities.size() * sizeof(Cell);
+		text.clear();
+		identities.clear();
+		if (parkedBytes <= maxParkedBytes) return;
+
+		// Too much is parked, so this thread waits until either enough is released, or its rank comes up (after which
+		// the rest of a rank still being searched is written straight through). A complete rank waits until it has
+		// been released rather than until enough is, since the next rank may be the next in this thread's own range
+		released.wait(lock, [&]() {
+			return parkedBytes <= maxParkedBytes || (complete ? nextRank > rank : nextRank == rank);
+		});
+		if (complete || nextRank != rank) return;
+	}
+
+	// This thread holds the next rank, so it alone writes (with the lock released)
+	auto iter = parked.find(rank);
+	if (iter != parked.end()) {
+		ParkedOutput parkedOutput = move(iter->second);
+		parked.erase(iter);
+		parkedBytes -= parkedOutput.text.size() + parkedOutput.identities.size() * sizeof(Cell);
+		released.notify_all();
+		lock.unlock();
+		release(parkedOutput.text, parkedOutput.identities);
+		lock.lock();
+	}
+	lock.unlock();
+	release(text, identities);
+	if (!complete) return;
+
+	// Passes the next rank on, releasing every complete rank after this one along the way
+	lock.lock();
+	++nextRank;
+	iter = parked.find(nextRank);
+	while (iter != parked.end() && iter->second.complete) {
+		ParkedOutput parkedOutput = move(iter->second);
+		parked.erase(iter);
+		parkedBytes -= parkedOutput.text.size() + parkedOutput.identities.size() * sizeof(Cell);
+		released.notify_all();
+		lock.unlock();
+		release(parkedOutput.text, parkedOutput.identities);
+		lock.lock();
+		++nextRank;
+		iter = parked.find(nextRank);
+	}
+	released.notify_all();
+}
+
+template <typename Cell>
+void OrderedOutput<Cell>::release(string& text, vector<Cell>& identities) {
+	if (!text.empty()) {
+		output.write(text);
+		text.clear();
+	}
+	vector<Cell> set(setSize);
+	for (size_t i = 0; i < identities.size(); i += setSize) {
+		copy(identities.begin() + i, identities.begin() + i + setSize, set.begin());
+		expander->submit(set);
+	}
+	identities.clear();
+}
+
+template class OrderedOutput<uint8_t>;
+template class OrderedOutput<uint16_t>;
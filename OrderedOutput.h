@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+
+using std::vector;
+using std::string;
+using std::map;
+using std::mutex;
+using std::condition_variable;
+
+class OutputWriter;
+template <typename Cell> class TransformationExpander;
+
+/*
+* Reorder stage between the threads of a parallel search and the output, which releases the output of each axis
+* solidification set in rank order, so that the output is byte identical to that of a serial search whatever the thread
+* count. The ranks here are the places of the sets in the print order (see ParallelSearch::run()).
+*
+* The thread searching the next rank to be released writes its output straight through. Other threads park theirs
+* until every rank before it has been released, and once more than maxParkedBytes is parked, they wait (before
+* searching any further) for their rank to come up, or to be released if already complete. The thread searching the
+* next rank never waits, so the search always makes progress
+*/
+template <typename Cell>
+class OrderedOutput {
+	// Output of a rank, waiting for the ranks before it to be released
+	struct ParkedOutput {
+		string text;
+		vector<Cell> identities; // Sets to expand, one after the other
+		bool complete = false;
+	};
+
+	OutputWriter& output;
+	TransformationExpander<Cell>* expander; // Expands identities (PrintOption::ALL), or nullptr when only text is written
+	int setSize;
+	size_t maxParkedBytes;
+
+	mutex stateMutex;
+	condition_variable released; // Signalled whenever nextRank advances, or parked output is released
+	unsigned long nextRank; // Rank whose output is written next
+	map<unsigned long, ParkedOutput> parked;
+	size_t parkedBytes = 0;
+
+	// Writes the text and submits the identities for expansion. Only ever called by the thread holding nextRank
+	void release(string& text, vector<Cell>& identities);
+
+public:
+	OrderedOutput(OutputWriter& output, TransformationExpander<Cell>* expander, int setSize, unsigned long firstRank,
+		size_t maxParkedBytes);
+
+	// Hands over output of the rank (clearing text and identities), which is complete once the rank's subtree has
+	// been searched. Every rank from firstRank on must be completed, even if it has no output
+	void write(unsigned long rank, string& text, vector<Cell>& identities, bool complete);
+};
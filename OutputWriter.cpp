@@ -0,0 +1,88 @@
+#include "OutputWriter.h"
+#include "CubeRing.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+OutputWriter::OutputWriter(size_t _flushThreshold) {
+	flushThreshold = _flushThreshold;
+	buffer.reserve(flushThreshold * 2);
+}
+
+OutputWriter::~OutputWriter() {
+	close();
+}
+
+bool OutputWriter::open(const string& path) {
+	close();
+	fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	failed = fd < 0;
+	if (failed) {
+		perror(("Unable to create '" + path + "'").c_str());
+	}
+	return !failed;
+}
+
+void OutputWriter::openRing(CubeRing* _ring) {
+	close();
+	ring = _ring;
+	failed = false;
+}
+
+void OutputWriter::close() {
+	if (fd >= 0 || ring != nullptr) {
+		flush();
+	}
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+	ring = nullptr;
+}
+
+bool OutputWriter::hasFailed() {
+	return failed;
+}
+
+string& OutputWriter::getBuffer() {
+	return buffer;
+}
+
+void OutputWriter::flushIfFull() {
+	if (buffer.size() >= flushThreshold) {
+		flush();
+	}
+}
+
+void OutputWriter::write(const string& data) {
+	flush();
+	writeFully(data.data(), data.size());
+}
+
+void OutputWriter::flush() {
+	writeFully(buffer.data(), buffer.size());
+	buffer.clear();
+}
+
+void OutputWriter::writeFully(const char* data, size_t size) {
+	if (ring != nullptr) {
+		ring->publish(data, size);
+		return;
+	}
+	if (fd < 0 || failed) return;
+
+	while (size > 0) {
+		ssize_t written = ::write(fd, data, size);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+			perror("Unable to write output");
+			failed = true;
+			return;
+		}
+		data += written;
+		size -= written;
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+
+using std::string;
+
+class CubeRing;
+
+/*
+* Buffered writer for the text output file. Text is formatted straight into the writer's buffer (see getBuffer()),
+* which is handed to the OS in large write() calls once it passes flushThreshold, bypassing iostream formatting and
+* its per call locale and state checks entirely
+*/
+class OutputWriter {
+	int fd = -1;
+	CubeRing* ring = nullptr;
+	string buffer;
+	size_t flushThreshold;
+
+	// Set once the file couldn't be created or written to (reported through perror()), after which output is discarded
+	bool failed = false;
+
+	// Writes all of the data to the file, retrying partial writes
+	void writeFully(const char* data, size_t size);
+
+public:
+	OutputWriter(size_t flushThreshold = 1 << 20);
+	~OutputWriter();
+
+	// Creates (or truncates) the file, closing any file previously open
+	bool open(const string& path);
+	void close();
+
+	// Publishes everything written to the ring (whole records only), closing any file previously open
+	void openRing(CubeRing* ring);
+
+	// Whether any output was lost since the file was opened
+	bool hasFailed();
+
+	// Buffer to append formatted text to, followed by a call to flushIfFull()
+	string& getBuffer();
+	void flushIfFull();
+
+	// Writes out the buffer, followed by the data given (without copying it into the buffer)
+	void write(const string& data);
+
+	void flush();
+};
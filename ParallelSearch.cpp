@@ -0,0 +1,129 @@
+#include "ParallelSearch.h"
+#include "Generator.h"
+#include "OrderedOutput.h"
+#include <thread>
+
+using namespace std;
+
+// Most output parked by workers waiting for the ranks before theirs to be written
+const size_t maxParkedOutputBytes = size_t(256) << 20;
+
+template <typename Cell>
+ParallelSearch<Cell>::ParallelSearch(Generator<Cell>& _generator, int _threadCount) : generator(_generator) {
+	threadCount = _threadCount;
+	topology.placeThreads(threadCount, workerCpus, workerNodes);
+	workRanges.resize(threadCount);
+	nodeAxisCompletionCounts.resize(topology.getNodes().size());
+	nodeReplicated = make_unique<once_flag[]>(topology.getNodes().size());
+}
+
+template <typename Cell>
+void ParallelSearch<Cell>::run(unsigned long firstRank, unsigned long lastRank) {
+	unique_ptr<OrderedOutput<Cell>> ordered;
+	if (generator.printOption != PrintOption::NONE) {
+		ordered = make_unique<OrderedOutput<Cell>>(generator.output, generator.transformationExpander, generator.setSize, 
+			firstRank, maxParkedOutputBytes);
+		orderedOutput = ordered.get();
+	}
+
+	// No worker steals until every worker's range exists
+	latch rangesReady(threadCount);
+	vector<thread> workers;
+	for (int worker = 0; worker < threadCount; ++worker) {
+		workers.emplace_back([this, worker, firstRank, lastRank, &rangesReady]() {
+			work(worker, firstRank, lastRank, rangesReady);
+		});
+	}
+	for (thread& worker : workers) {
+		worker.join();
+	}
+	orderedOutput = nullptr;
+}
+
+template <typename Cell>
+void ParallelSearch<Cell>::work(int worker, unsigned long firstRank, unsigned long lastRank, latch& rangesReady) {
+	// Pinned before allocating anything, so that everything below is allocated on the worker's own node
+	Topology::pinCurrentThread(workerCpus[worker]);
+	int node = workerNodes[worker];
+	call_once(nodeReplicated[node], [this, node]() {
+		if (!generator.axisSetCache.isLoaded()) {
+			nodeAxisCompletionCounts[node] = make_unique<unordered_map<string, unsigned long>>(
+				generator.axisCompletionCounts);
+		}
+	});
+	Generator<Cell> replica(generator, nodeAxisCompletionCounts[node].get());
+	replica.orderedOutput = orderedOutput;
+
+	unsigned long rankCount = lastRank - firstRank;
+	workRanges[worker] = make_unique<WorkRange>();
+	workRanges[worker]->next = firstRank + rankCount * worker / threadCount;
+	workRanges[worker]->end = firstRank + rankCount * (worker + 1) / threadCount;
+	rangesReady.arrive_and_wait();
+
+	if (!replica.walkingPrintOrder) {
+		vector<Cell> set(replica.setSize);
+		unsigned long rank;
+		while (takeRank(worker, rank)) {
+			replica.traverseAxisSolidificationSet(rank, set);
+		}
+	} else {
+		replica.parallelSearch = this;
+		replica.parallelWorker = worker;
+		replica.walkClaimedAxisSolidificationSets();
+	}
+}
+
+template <typename Cell>
+bool ParallelSearch<Cell>::takeRank(int worker, unsigned long& rank) {
+	WorkRange& range = *workRanges[worker];
+	{
+		lock_guard<mutex> lock(range.rangeMutex);
+		if (range.next < range.end) {
+			rank = range.next++;
+			return true;
+		}
+	}
+
+	while (true) {
+		int victim = findVictim(worker, true);
+		if (victim < 0) victim = findVictim(worker, false);
+		if (victim < 0) return false;
+
+		// The victim may have run down its range since it was found, in which case another is looked for
+		unsigned long stolenNext, stolenEnd;
+		{
+			WorkRange& victimRange = *workRanges[victim];
+			lock_guard<mutex> lock(victimRange.rangeMutex);
+			if (victimRange.next >= victimRange.end) continue;
+			stolenNext = victimRange.next + (victimRange.end - victimRange.next) / 2;
+			stolenEnd = victimRange.end;
+			victimRange.end = stolenNext;
+		}
+
+		lock_guard<mutex> lock(range.rangeMutex);
+		rank = stolenNext;
+		range.next = stolenNext + 1;
+		range.end = stolenEnd;
+		return true;
+	}
+}
+
+template <typename Cell>
+int ParallelSearch<Cell>::findVictim(int thief, bool sameNode) {
+	int victim = -1;
+	unsigned long victimRemaining = 0;
+	for (int worker = 0; worker < threadCount; ++worker) {
+		if (worker == thief || (workerNodes[worker] == workerNodes[thief]) != sameNode) continue;
+
+		WorkRange& range = *workRanges[worker];
+		lock_guard<mutex> lock(range.rangeMutex);
+		if (range.end - range.next > victimRemaining && range.next < range.end) {
+			victim = worker;
+			victimRemaining = range.end - range.next;
+		}
+	}
+	return victim;
+}
+
+template class ParallelSearch<uint8_t>;
+template class ParallelSearch<uint16_t>;
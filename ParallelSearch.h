@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <latch>
+#include <unordered_map>
+#include "Topology.h"
+
+using std::vector;
+using std::string;
+using std::unique_ptr;
+using std::mutex;
+using std::once_flag;
+using std::latch;
+using std::unordered_map;
+
+template <typename Cell> class Generator;
+template <typename Cell> class OrderedOutput;
+
+/*
+* Multithreaded search over a range of axis solidification sets, placed for NUMA systems. Each worker thread is pinned
+* to a CPU (spread over the nodes by Topology) before it allocates anything, so that its replica of the generator (the
+* segment plan and all mutable search state) and its work range live in its own node's memory. The axis completion
+* counts needed to place sets from their ranks are replicated once per node and shared by that node's workers.
+*
+* Each worker starts with an equal share of the ranks, and takes them one at a time. A worker that runs out steals
+* the upper half of the largest remaining range, looking first at the workers of its own node and only then at those
+* of other nodes. When cubes are printed, each worker's output passes through an OrderedOutput, so that it is written in 
+* print order
+*/
+template <typename Cell>
+class ParallelSearch {
+	// Ranks [next, end) still to be searched by a worker, padded out to a cache line of its own
+	struct alignas(64) WorkRange {
+		mutex rangeMutex;
+		unsigned long next = 0;
+		unsigned long end = 0;
+	};
+
+	Generator<Cell>& generator;
+	Topology topology;
+	int threadCount;
+	vector<int> workerCpus;
+	vector<int> workerNodes; // Index of each worker's node within the topology
+	vector<unique_ptr<WorkRange>> workRanges; // Allocated by each worker
+
+	// Per node copies of the primary generator's axis completion counts (unless it has the axis set cache mapped),
+	// made by the first worker of the node to start
+	vector<unique_ptr<unordered_map<string, unsigned long>>> nodeAxisCompletionCounts;
+	unique_ptr<once_flag[]> nodeReplicated;
+
+	OrderedOutput<Cell>* orderedOutput = nullptr;
+
+	void work(int worker, unsigned long firstRank, unsigned long lastRank, latch& rangesReady);
+
+	// Worker (other than the thief) with the most ranks remaining, searching only the thief's node when sameNode is
+	// set, or -1 if none has any remaining
+	int findVictim(int thief, bool sameNode);
+
+public:
+	ParallelSearch(Generator<Cell>& generator, int threadCount);
+
+	// Searches the axis solidification sets [firstRank, lastRank) on every worker, returning once all are searched. 
+	// Printing runs number the sets by their place in the print order rather than by their rank
+	void run(unsigned long firstRank, unsigned long lastRank);
+
+	// Takes the next rank for the worker (stealing one if its range has run out), returning false once every range is
+	// exhausted
+	bool takeRank(int worker, unsigned long& rank);
+};
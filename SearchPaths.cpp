@@ -0,0 +1,81 @@
+#include "SearchPaths.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char searchPathMagic[8] = { 'M', 'H', 'C', 'P', 'A', 'T', 'H', 'S' };
+
+// Bumped whenever the choices recorded, or how they are numbered, change
+const uint32_t searchPathVersion = 1;
+
+void appendSearchPathHeader(string& buffer, int sideLength, int dimensionality, uint64_t planHash) {
+	SearchPathHeader header = {};
+	memcpy(header.magic, searchPathMagic, sizeof(searchPathMagic));
+	header.version = searchPathVersion;
+	header.sideLength = sideLength;
+	header.dimensionality = dimensionality;
+	header.planHash = planHash;
+	buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void appendSearchPathChoice(string& buffer, unsigned long choice) {
+	while (choice >= 0x80) {
+		buffer.push_back(char((choice & 0x7f) | 0x80));
+		choice >>= 7;
+	}
+	buffer.push_back(char(choice));
+}
+
+SearchPathReader::~SearchPathReader() {
+	if (data != nullptr) {
+		munmap(const_cast<char*>(data), dataSize);
+	}
+}
+
+bool SearchPathReader::open(const string& path, int sideLength, int dimensionality, uint64_t planHash) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat fileStat;
+	void* mapping = MAP_FAILED;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size >= (off_t)sizeof(SearchPathHeader)) {
+		mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (mapping == MAP_FAILED) return false;
+
+	const SearchPathHeader* header = static_cast<const SearchPathHeader*>(mapping);
+	bool matches = memcmp(header->magic, searchPathMagic, sizeof(searchPathMagic)) == 0
+		&& header->version == searchPathVersion
+		&& header->sideLength == sideLength
+		&& header->dimensionality == dimensionality
+		&& header->planHash == planHash;
+	if (!matches) {
+		munmap(mapping, fileStat.st_size);
+		return false;
+	}
+
+	madvise(mapping, fileStat.st_size, MADV_SEQUENTIAL);
+	data = static_cast<const char*>(mapping);
+	dataSize = fileStat.st_size;
+	offset = sizeof(SearchPathHeader);
+	return true;
+}
+
+bool SearchPathReader::readChoice(unsigned long& choice) {
+	choice = 0;
+	for (int shift = 0; offset < dataSize && shift < 64; shift += 7) {
+		unsigned char byte = data[offset++];
+		choice |= (unsigned long)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) return true;
+	}
+	return false;
+}
+
+bool SearchPathReader::isAtEnd() {
+	return offset >= dataSize;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+using std::string;
+
+// Layout of the start of a search path file, followed by one record per cube identity (see SearchPathReader)
+struct SearchPathHeader {
+	char magic[8];
+	uint32_t version;
+	int32_t sideLength;
+	int32_t dimensionality;
+	uint64_t planHash;
+};
+
+// Appends the header of a search path file for the configuration and segment plan to the buffer
+void appendSearchPathHeader(string& buffer, int sideLength, int dimensionality, uint64_t planHash);
+
+// Appends a choice to the buffer as a variable width integer (LEB128: 7 bits a byte, the low bits first, with the top
+// bit set on every byte but the last)
+void appendSearchPathChoice(string& buffer, unsigned long choice);
+
+/*
+* Reader of the search path files written by PrintOption::PATHS, in which each cube identity is stored as the choices
+* its search path made rather than as its cells: the rank of its axis solidification set (in the canonical order), the
+* order its axis segments were placed in and the arrangement of each, and then for each non-axis segment the index of
+* its combination among the ascending combinations of the values left that add up to its sum, followed by the index of
+* its arrangement. Orders and arrangements are indexed as perms in lexicographic order. Each choice is a variable width
+* integer, so an identity takes a few bytes per segment, however many cells the cube has.
+*
+* Files are identified by the configuration and a hash of the segment plan, as the choices can only be replayed
+* through the same plan (see Generator::decodePaths()). The file is memory mapped and read through in order
+*/
+class SearchPathReader {
+	const char* data = nullptr; // Mapped file, or nullptr if not open
+	size_t dataSize = 0;
+	size_t offset = 0;
+
+public:
+	~SearchPathReader();
+
+	// Maps the file, returning false if it is missing or doesn't match the configuration and plan given
+	bool open(const string& path, int sideLength, int dimensionality, uint64_t planHash);
+
+	// Reads the next choice, returning false at the end of the file (or at a truncated choice)
+	bool readChoice(unsigned long& choice);
+
+	// Whether every record has been read
+	bool isAtEnd();
+};
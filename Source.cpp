@@ -1,21 +1,153 @@
 ﻿#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <random>
 #include "Generator.h"
 
 using std::cout;
 using std::endl;
 using std::cin;
+using std::string;
+using std::vector;
+using std::min;
+using std::from_chars;
+using std::errc;
+using std::random_device;
 
-int main() {
-	cout << "Magic cube generator" << endl;
-	cout << "Enter sidelength: ";
-	int sideLength;
-	cin >> sideLength;
-	cout << "Enter dimensionality: ";
-	int dimensionality;
-	cin >> dimensionality;
-	cout << "Output will be saved to 'Magic Cubes.txt'. Output all cubes (a), identities only (i), or none (n): ";
-	char choice;
-	cin >> choice;
+// Parses the whole of the text as an integer of the value's type, returning false if it isn't one
+template <typename Integer> bool parseInteger(const string& text, Integer& value) {
+	auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+	return error == errc() && end == text.data() + text.size();
+}
+
+// Restriction of the cell at coords (one per axis, the x axis first) to values in [minValue, maxValue], as given by 
+// spec ("x,y,...=value" or "x,y,...=low-high")
+struct Constraint {
+	string spec;
+	vector<int> coords;
+	int minValue;
+	int maxValue;
+};
+
+// Parses the constraint's spec into its coordinates and value range, returning false if it is malformed. Whether they 
+// lie within the cube is only known once its size is
+bool parseConstraint(Constraint& constraint) {
+	const string& spec = constraint.spec;
+	size_t equals = spec.find('=');
+	if (equals == string::npos) return false;
+
+	constraint.coords.clear();
+	for (size_t start = 0; start <= equals;) {
+		size_t comma = min(spec.find(',', start), equals);
+		int coord;
+		if (!parseInteger(spec.substr(start, comma - start), coord) || coord < 0) return false;
+		constraint.coords.push_back(coord);
+		start = comma + 1;
+	}
+
+	string range = spec.substr(equals + 1);
+	size_t dash = range.find('-');
+	if (!parseInteger(range.substr(0, dash), constraint.minValue)) return false;
+	constraint.maxValue = constraint.minValue;
+	if (dash != string::npos && !parseInteger(range.substr(dash + 1), constraint.maxValue)) return false;
+	return constraint.minValue >= 1 && constraint.minValue <= constraint.maxValue;
+}
+
+// Adds every constraint to the generator, reporting the first lying outside its cube
+template <typename Cell>
+bool addConstraints(Generator<Cell>& generator, vector<Constraint>& constraints) {
+	for (Constraint& constraint : constraints) {
+		if (!generator.addConstraint(constraint.coords, constraint.minValue, constraint.maxValue)) {
+			cout << "Invalid constraint '" << constraint.spec << "' for this cube" << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// Optional engine flags
+struct Options {
+	bool meetInTheMiddle = false;
+	int splitSegmentIndex = 0;
+	size_t memoryLimitMb = 1024;
+	unsigned long firstAxisSolidificationSet = 0;
+	unsigned long axisSolidificationSetCount = ULONG_MAX;
+	bool useAxisSetCache = true;
+	bool useSubtreeCache = true;
+	bool verifySubtreeCache = false;
+	string statsPath;
+	bool useStatsFile = true;
+	unsigned threadCount = 1;
+	size_t transpositionTableMb = 0;
+	vector<Constraint> constraints;
+	unsigned long sampleCount = 0;
+	uint64_t seed = random_device()();
+	bool uniformSampling = false;
+	string streamName;
+	string decodePath;
+	string buildFrontierPath;
+	int frontierDepth = 1;
+	unsigned chunkFrames = 1024;
+	string searchFrontierPath;
+};
+
+// Runs the generator over cells of the given type, as chosen for the cube by getCellBits()
+template <typename Cell>
+int run(Options& options, int sideLength, int dimensionality) {
+	// The meet-in-the-middle engine only counts cubes
+	if (options.meetInTheMiddle) {
+		Generator<Cell> generator(sideLength, dimensionality);
+		if (!options.useAxisSetCache) generator.setAxisSetCachePath("");
+		if (!options.useStatsFile) generator.setStatsPath("");
+		else if (!options.statsPath.empty()) generator.setStatsPath(options.statsPath);
+		return generator.generateMeetInTheMiddle(options.splitSegmentIndex, options.memoryLimitMb << 20) ? 0 : 1;
+	}
+
+	// Frontier files are built and searched by count-only runs of their own, which may be spread over many processes
+	if (!options.buildFrontierPath.empty() || !options.searchFrontierPath.empty()) {
+		Generator<Cell> generator(sideLength, dimensionality);
+		if (!options.useAxisSetCache) generator.setAxisSetCachePath("");
+		if (!options.buildFrontierPath.empty()) {
+			return generator.buildFrontier(options.buildFrontierPath, options.frontierDepth, options.chunkFrames, 
+				options.firstAxisSolidificationSet, options.axisSolidificationSetCount) ? 0 : 1;
+		}
+		generator.setThreadCount(options.threadCount);
+		generator.setTranspositionTableSize(options.transpositionTableMb << 20);
+		return generator.searchFrontier(options.searchFrontierPath) ? 0 : 1;
+	}
+
+	// Decoding rebuilds the identities of a search path file rather than searching for them
+	if (!options.decodePath.empty()) {
+		Generator<Cell> generator(sideLength, dimensionality);
+		if (!options.useAxisSetCache) generator.setAxisSetCachePath("");
+		generator.setStreamName(options.streamName);
+		return generator.decodePaths(options.decodePath) ? 0 : 1;
+	}
+
+	// Sampling writes the cubes drawn, whatever they are
+	if (options.sampleCount > 0) {
+		Generator<Cell> generator(sideLength, dimensionality);
+		if (!options.useAxisSetCache) generator.setAxisSetCachePath("");
+		generator.setThreadCount(options.threadCount);
+		if (!addConstraints(generator, options.constraints)) return 1;
+		generator.setStreamName(options.streamName);
+		cout << "Sampling " << options.sampleCount << " cubes with seed " << options.seed << " to " 
+			<< (options.streamName.empty() ? "'Magic Cubes.txt'" : "stream '" + options.streamName + "'") << endl;
+		return generator.generateSample(options.sampleCount, options.seed, options.uniformSampling) ? 0 : 1;
+	}
+
+	// Streaming sends the identities to the consumer in place of the output file
+	char choice = 'i';
+	if (options.streamName.empty()) {
+		cout << "Output will be saved to 'Magic Cubes.txt'. Output all cubes (a), identities only (i), "
+			<< "the search paths of identities to 'Magic Cubes.paths' instead (p), or none (n): ";
+		cin >> choice;
+	} else {
+		cout << "Streaming cube identities to '" << options.streamName << "'" << endl;
+	}
 	PrintOption printOption;
 	switch (choice) {
 	case 'a':
@@ -24,12 +156,124 @@ int main() {
 	case 'i':
 		printOption = PrintOption::IDENTITIES;
 		break;
+	case 'p':
+		printOption = PrintOption::PATHS;
+		break;
 	default:
 		printOption = PrintOption::NONE;
 		break;
 	}
 	
-	Generator generator(sideLength, dimensionality);
-	generator.generate(printOption);
-	return 0;
+	Generator<Cell> generator(sideLength, dimensionality);
+	if (!options.useAxisSetCache) generator.setAxisSetCachePath("");
+	if (!options.useStatsFile) generator.setStatsPath("");
+	else if (!options.statsPath.empty()) generator.setStatsPath(options.statsPath);
+	if (!options.useSubtreeCache) generator.setSubtreeCachePath("");
+	generator.setVerifyingSubtreeCache(options.verifySubtreeCache);
+	generator.setThreadCount(options.threadCount);
+	generator.setTranspositionTableSize(options.transpositionTableMb << 20);
+	generator.setStreamName(options.streamName);
+	if (!addConstraints(generator, options.constraints)) return 1;
+	return generator.generate(printOption, options.firstAxisSolidificationSet, options.axisSolidificationSetCount) 
+		? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		bool valid = true;
+		if (arg == "--meet-in-the-middle") {
+			options.meetInTheMiddle = true;
+		} else if (arg == "--split" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.splitSegmentIndex) && options.splitSegmentIndex >= 0;
+		} else if (arg == "--memory" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.memoryLimitMb);
+		} else if (arg == "--first-axis-set" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.firstAxisSolidificationSet);
+		} else if (arg == "--axis-set-count" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.axisSolidificationSetCount);
+		} else if (arg == "--no-axis-set-cache") {
+			options.useAxisSetCache = false;
+		} else if (arg == "--no-subtree-cache") {
+			options.useSubtreeCache = false;
+		} else if (arg == "--verify-subtree-cache") {
+			options.verifySubtreeCache = true;
+		} else if (arg == "--stats-file" && i + 1 < argc) {
+			options.statsPath = argv[++i];
+		} else if (arg == "--no-stats-file") {
+			options.useStatsFile = false;
+		} else if (arg == "--threads" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.threadCount) && options.threadCount > 0;
+		} else if (arg == "--transposition-table" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.transpositionTableMb);
+		} else if (arg == "--fix" && i + 1 < argc) {
+			Constraint constraint;
+			constraint.spec = argv[++i];
+			if (!parseConstraint(constraint)) {
+				cout << "Invalid constraint '" << constraint.spec << "'" << endl;
+				return 1;
+			}
+			options.constraints.push_back(constraint);
+		} else if (arg == "--sample" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.sampleCount);
+		} else if (arg == "--seed" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.seed);
+		} else if (arg == "--uniform") {
+			options.uniformSampling = true;
+		} else if (arg == "--stream" && i + 1 < argc) {
+			options.streamName = argv[++i];
+		} else if (arg == "--decode-paths" && i + 1 < argc) {
+			options.decodePath = argv[++i];
+		} else if (arg == "--build-frontier" && i + 1 < argc) {
+			options.buildFrontierPath = argv[++i];
+		} else if (arg == "--frontier-depth" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.frontierDepth) && options.frontierDepth >= 0;
+		} else if (arg == "--chunk-frames" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], options.chunkFrames) && options.chunkFrames > 0;
+		} else if (arg == "--search-frontier" && i + 1 < argc) {
+			options.searchFrontierPath = argv[++i];
+		} else {
+			valid = false;
+		}
+		if (!valid) {
+			cout << "Usage: " << argv[0] << " [--meet-in-the-middle [--split segmentIndex] [--memory megabytes]] "
+				<< "[--first-axis-set rank] [--axis-set-count count] [--no-axis-set-cache] "
+				<< "[--no-subtree-cache | --verify-subtree-cache] [--stats-file path | --no-stats-file] "
+				<< "[--threads count] [--transposition-table megabytes] [--fix x,y,...=value|low-high]... " 
+				<< "[--sample count [--seed seed] [--uniform]] [--stream name] [--decode-paths file] " 
+				<< "[--build-frontier file [--frontier-depth segmentIndex] [--chunk-frames count] | --search-frontier file]" 
+				<< endl;
+			return 1;
+		}
+	}
+
+	// Constraints are checked before prompting for the cube, as far as they can be without knowing its size
+	if (!options.constraints.empty() && options.meetInTheMiddle) {
+		cout << "Constraints are not supported by the meet-in-the-middle engine" << endl;
+		return 1;
+	}
+	if (!options.constraints.empty() && (!options.buildFrontierPath.empty() || !options.searchFrontierPath.empty())) {
+		cout << "Constraints are not supported by frontier files" << endl;
+		return 1;
+	}
+
+	cout << "Magic cube generator" << endl;
+	cout << "Enter sidelength: ";
+	int sideLength;
+	cin >> sideLength;
+	cout << "Enter dimensionality: ";
+	int dimensionality;
+	cin >> dimensionality;
+
+	// The search state is held in cells as narrow as the cube's values allow
+	switch (getCellBits(sideLength, dimensionality)) {
+	case 8:
+		return run<uint8_t>(options, sideLength, dimensionality);
+	case 16:
+		return run<uint16_t>(options, sideLength, dimensionality);
+	default:
+		cout << "Cubes of more than " << UINT16_MAX << " cells are not supported" << endl;
+		return 1;
+	}
 }
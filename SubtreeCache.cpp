@@ -0,0 +1,83 @@
+#include "SubtreeCache.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char subtreeCacheMagic[8] = { 'M', 'H', 'C', 'S', 'U', 'B', 'T', 'R' };
+
+// Bumped whenever a change to the engine could change the results of a subtree
+const uint32_t subtreeCacheVersion = 1;
+
+SubtreeCache::~SubtreeCache() {
+	if (fd >= 0) {
+		close(fd);
+	}
+}
+
+bool SubtreeCache::open(const string& path, int sideLength, int dimensionality, uint64_t planHash) {
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+	if (fd < 0) return false;
+
+	SubtreeCacheHeader header = {};
+	memcpy(header.magic, subtreeCacheMagic, sizeof(subtreeCacheMagic));
+	header.version = subtreeCacheVersion;
+	header.sideLength = sideLength;
+	header.dimensionality = dimensionality;
+	header.planHash = planHash;
+
+	// Checking and (re)writing the header is done under an exclusive lock, so that concurrent shards agree on it
+	flock(fd, LOCK_EX);
+	SubtreeCacheHeader fileHeader;
+	bool matches = pread(fd, &fileHeader, sizeof(fileHeader), 0) == sizeof(fileHeader)
+		&& memcmp(&fileHeader, &header, sizeof(header)) == 0;
+	if (!matches) {
+		if (ftruncate(fd, 0) != 0 || write(fd, &header, sizeof(header)) != sizeof(header)) {
+			flock(fd, LOCK_UN);
+			close(fd);
+			fd = -1;
+			return false;
+		}
+	}
+
+	// Reads every complete record, dropping any record torn by an interrupted run so that appends stay aligned
+	SubtreeResult result;
+	off_t offset = sizeof(header);
+	while (pread(fd, &result, sizeof(result), offset) == sizeof(result)) {
+		results[result.rank] = result;
+		offset += sizeof(result);
+	}
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) == 0 && fileStat.st_size != offset && ftruncate(fd, offset) != 0) {
+		flock(fd, LOCK_UN);
+		close(fd);
+		fd = -1;
+		return false;
+	}
+	flock(fd, LOCK_UN);
+	return true;
+}
+
+bool SubtreeCache::isOpen() {
+	return fd >= 0;
+}
+
+const SubtreeResult* SubtreeCache::find(uint64_t rank) {
+	auto iter = results.find(rank);
+	return iter == results.end() ? nullptr : &iter->second;
+}
+
+void SubtreeCache::record(const SubtreeResult& result) {
+	results[result.rank] = result;
+	if (write(fd, &result, sizeof(result)) != sizeof(result)) {
+		close(fd);
+		fd = -1;
+	}
+}
+
+size_t SubtreeCache::getResultCount() {
+	return results.size();
+}
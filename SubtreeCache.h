@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+
+using std::string;
+using std::unordered_map;
+
+// Result of fully traversing the subtree of a single axis solidification set
+struct SubtreeResult {
+	uint64_t rank; // Rank of the axis solidification set within the canonical order
+	uint64_t identityCount;
+	uint64_t nodeCount; // Number of non-axis segment resolution steps taken
+	double seconds;
+};
+
+// Layout of the start of a subtree result database, followed by any number of SubtreeResult records
+struct SubtreeCacheHeader {
+	char magic[8];
+	uint32_t version;
+	int32_t sideLength;
+	int32_t dimensionality;
+	uint32_t padding;
+	uint64_t planHash;
+};
+
+/*
+* Sidecar database of per axis solidification set results, so that count-only runs can reuse the totals of any subtree
+* already traversed (by earlier runs, shards or resumed runs) and only traverse the rest.
+*
+* The database is an append only log of SubtreeResult records, with later records for the same rank superseding
+* earlier ones. Several processes may append to it at once, as each record is written with a single O_APPEND write. A
+* database belonging to another configuration, plan or format version (bumped whenever a change to the engine could
+* change results) is cleared when opened
+*/
+class SubtreeCache {
+	int fd = -1;
+	unordered_map<uint64_t, SubtreeResult> results;
+
+public:
+	~SubtreeCache();
+
+	// Opens the database (creating or clearing it as needed) and reads every result in it. Returns false if the file
+	// can't be opened
+	bool open(const string& path, int sideLength, int dimensionality, uint64_t planHash);
+
+	bool isOpen();
+
+	// Returns the latest result recorded for the rank, or nullptr if there is none
+	const SubtreeResult* find(uint64_t rank);
+
+	// Appends the result to the database
+	void record(const SubtreeResult& result);
+
+	size_t getResultCount();
+};
@@ -0,0 +1,137 @@
+#include "Telemetry.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include <unistd.h>
+
+using namespace std;
+using namespace chrono;
+
+// Reports are spaced at 10% of the time elapsed so far, within these bounds
+const milliseconds minReportInterval(1000);
+const milliseconds maxReportInterval(60000);
+
+// Resident set size of this process in bytes (0 if unavailable)
+unsigned long getResidentBytes() {
+	unsigned long totalPages = 0;
+	unsigned long residentPages = 0;
+	ifstream statm("/proc/self/statm");
+	if (!(statm >> totalPages >> residentPages)) return 0;
+	return residentPages * sysconf(_SC_PAGESIZE);
+}
+
+Telemetry::~Telemetry() {
+	stop();
+}
+
+TelemetryCounters& Telemetry::addThread() {
+	lock_guard<mutex> lock(stateMutex);
+	return counterSlots.emplace_back();
+}
+
+TelemetrySnapshot Telemetry::read() {
+	TelemetrySnapshot snapshot;
+	lock_guard<mutex> lock(stateMutex);
+	for (TelemetryCounters& counters : counterSlots) {
+		snapshot.cubeIdentityCount += counters.cubeIdentityCount;
+		snapshot.axisSolidificationSetCount += counters.axisSolidificationSetCount;
+		snapshot.nodeCount += counters.nodeCount;
+		snapshot.transpositionHitCount += counters.transpositionHitCount;
+		snapshot.transpositionMissCount += counters.transpositionMissCount;
+	}
+	snapshot.seconds = duration<double>(high_resolution_clock::now() - startTime).count();
+	return snapshot;
+}
+
+void Telemetry::start(unsigned long _firstAxisSolidificationSet, unsigned long _lastAxisSolidificationSet,
+	unsigned long _totalAxisSolidificationSetCount, const string& _statsPath) {
+	stop();
+	firstAxisSolidificationSet = _firstAxisSolidificationSet;
+	lastAxisSolidificationSet = _lastAxisSolidificationSet;
+	totalAxisSolidificationSetCount = _totalAxisSolidificationSetCount;
+	statsPath = _statsPath;
+	startTime = high_resolution_clock::now();
+	reporting = true;
+	reporter = thread([this]() { report(); });
+}
+
+void Telemetry::stop() {
+	{
+		lock_guard<mutex> lock(stateMutex);
+		if (!reporting) return;
+		reporting = false;
+	}
+	wake.notify_all();
+	reporter.join();
+	writeStats(read(), true);
+}
+
+void Telemetry::report() {
+	unique_lock<mutex> lock(stateMutex);
+	while (true) {
+		auto interval = duration_cast<milliseconds>(high_resolution_clock::now() - startTime) / 10;
+		interval = min(max(interval, minReportInterval), maxReportInterval);
+		if (wake.wait_for(lock, interval, [this]() { return !reporting; })) return;
+
+		lock.unlock();
+		TelemetrySnapshot snapshot = read();
+		int mins = floor(snapshot.seconds / 60);
+		double secs = snapshot.seconds - mins * 60;
+		cout << "Cube identity count: " << snapshot.cubeIdentityCount << " | Axis solidification set progress: "
+			<< firstAxisSolidificationSet + snapshot.axisSolidificationSetCount << "/" << totalAxisSolidificationSetCount
+			<< " | Time: " << (mins < 10 ? "0" : "") << mins << ":" << (secs < 10 ? "0" : "") << secs << endl;
+		writeStats(snapshot, false);
+		lock.lock();
+	}
+}
+
+void Telemetry::writeStats(const TelemetrySnapshot& snapshot, bool finished) {
+	if (statsPath.empty()) return;
+
+	// The remaining time is estimated from the rate axis solidification sets have been traversed at so far
+	double seconds = max(snapshot.seconds, 1e-3);
+	unsigned long remainingAxisSolidificationSetCount = lastAxisSolidificationSet - firstAxisSolidificationSet
+		- min(snapshot.axisSolidificationSetCount, lastAxisSolidificationSet - firstAxisSolidificationSet);
+	double axisSolidificationSetRate = snapshot.axisSolidificationSetCount / seconds;
+
+	// Written to a temporary file which then replaces the stats file, so that readers never see a partial write
+	string tempPath = statsPath + ".tmp";
+	{
+		ofstream stats(tempPath, ios::trunc);
+		if (!stats) return;
+		stats << "{\n";
+		stats << "\t\"finished\": " << (finished ? "true" : "false") << ",\n";
+		stats << "\t\"elapsedSeconds\": " << snapshot.seconds << ",\n";
+		stats << "\t\"cubeIdentities\": " << snapshot.cubeIdentityCount << ",\n";
+		stats << "\t\"axisSolidificationSetsTraversed\": " << snapshot.axisSolidificationSetCount << ",\n";
+		stats << "\t\"axisSolidificationSetsInRange\": " << lastAxisSolidificationSet - firstAxisSolidificationSet
+			<< ",\n";
+		stats << "\t\"firstAxisSolidificationSet\": " << firstAxisSolidificationSet << ",\n";
+		stats << "\t\"totalAxisSolidificationSets\": " << totalAxisSolidificationSetCount << ",\n";
+		stats << "\t\"nodes\": " << snapshot.nodeCount << ",\n";
+		stats << "\t\"cubeIdentitiesPerSecond\": " << snapshot.cubeIdentityCount / seconds << ",\n";
+		stats << "\t\"axisSolidificationSetsPerSecond\": " << axisSolidificationSetRate << ",\n";
+		stats << "\t\"nodesPerSecond\": " << snapshot.nodeCount / seconds << ",\n";
+		stats << "\t\"transpositionHits\": " << snapshot.transpositionHitCount << ",\n";
+		stats << "\t\"transpositionMisses\": " << snapshot.transpositionMissCount << ",\n";
+		unsigned long transpositionLookupCount = snapshot.transpositionHitCount + snapshot.transpositionMissCount;
+		stats << "\t\"transpositionHitRate\": " 
+			<< (transpositionLookupCount == 0 ? 0 : double(snapshot.transpositionHitCount) / transpositionLookupCount) 
+			<< ",\n";
+		stats << "\t\"etaSeconds\": ";
+		if (remainingAxisSolidificationSetCount == 0) {
+			stats << 0;
+		} else if (axisSolidificationSetRate > 0) {
+			stats << remainingAxisSolidificationSetCount / axisSolidificationSetRate;
+		} else {
+			stats << "null";
+		}
+		stats << ",\n";
+		stats << "\t\"residentBytes\": " << getResidentBytes() << "\n";
+		stats << "}\n";
+		if (!stats) return;
+	}
+	rename(tempPath.c_str(), statsPath.c_str());
+}
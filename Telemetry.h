@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+using std::string;
+using std::deque;
+using std::atomic;
+using std::thread;
+using std::mutex;
+using std::condition_variable;
+using std::chrono::high_resolution_clock;
+
+// Counter written by a single thread and read by any. Updates are plain relaxed loads and stores rather than locked
+// read-modify-writes, so they cost no more than updating an ordinary variable
+class TelemetryCounter {
+	atomic<unsigned long> value{ 0 };
+
+public:
+	void operator+=(unsigned long amount) {
+		value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+	}
+	void operator++() {
+		*this += 1;
+	}
+	operator unsigned long() const {
+		return value.load(std::memory_order_relaxed);
+	}
+};
+
+// Counters owned by a single search thread, padded out to a cache line of their own so that threads updating their
+// counters never contend over a line
+struct alignas(64) TelemetryCounters {
+	TelemetryCounter cubeIdentityCount;
+	TelemetryCounter axisSolidificationSetCount; // Axis solidification sets traversed (or whose results were reused)
+	TelemetryCounter nodeCount; // Non-axis segment resolution steps taken
+	TelemetryCounter transpositionHitCount; // Transposition table lookups that found a count
+	TelemetryCounter transpositionMissCount;
+};
+
+// Counters of every thread summed together, at a point in time
+struct TelemetrySnapshot {
+	unsigned long cubeIdentityCount = 0;
+	unsigned long axisSolidificationSetCount = 0;
+	unsigned long nodeCount = 0;
+	unsigned long transpositionHitCount = 0;
+	unsigned long transpositionMissCount = 0;
+	double seconds = 0; // Time since reporting started
+};
+
+/*
+* Progress reporting for a search. Each search thread registers its own TelemetryCounters, which are summed whenever
+* progress is read. Once started, a reporter thread periodically prints the progress, and rewrites a small JSON stats
+* file (counts, rates, estimated time remaining and resident memory) for monitoring tools to poll. The reporter waits
+* on a condition variable rather than sleeping, so stop() returns as soon as the final report is written
+*/
+class Telemetry {
+	mutex stateMutex;
+	condition_variable wake; // Signalled when reporting stops
+	deque<TelemetryCounters> counterSlots; // Deque, so that slots never move as threads register
+	bool reporting = false;
+	thread reporter;
+
+	string statsPath;
+	unsigned long firstAxisSolidificationSet = 0; // Range of axis solidification sets being traversed
+	unsigned long lastAxisSolidificationSet = 0;
+	unsigned long totalAxisSolidificationSetCount = 0;
+	high_resolution_clock::time_point startTime;
+
+	void report();
+	void writeStats(const TelemetrySnapshot& snapshot, bool finished);
+
+public:
+	~Telemetry();
+
+	// Registers a search thread, returning the counters it alone updates
+	TelemetryCounters& addThread();
+
+	// Sums the counters of every thread
+	TelemetrySnapshot read();
+
+	// Starts reporting the traversal of the axis solidification sets [first, last) of totalAxisSolidificationSetCount,
+	// writing the stats file to statsPath (unless empty)
+	void start(unsigned long firstAxisSolidificationSet, unsigned long lastAxisSolidificationSet,
+		unsigned long totalAxisSolidificationSetCount, const string& statsPath);
+
+	// Stops reporting, after writing the final stats
+	void stop();
+};
@@ -0,0 +1,105 @@
+#include "Topology.h"
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+
+using namespace std;
+
+const char* nodeDirectory = "/sys/devices/system/node";
+
+// Parses a kernel CPU list (eg. "0-3,8-11") into the CPUs it holds
+vector<int> parseCpuList(const string& list) {
+	vector<int> cpus;
+	size_t position = 0;
+	while (position < list.size()) {
+		size_t end = list.find(',', position);
+		if (end == string::npos) end = list.size();
+		string range = list.substr(position, end - position);
+		size_t dash = range.find('-');
+		try {
+			int first = stoi(range.substr(0, dash));
+			int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+			for (int cpu = first; cpu <= last; ++cpu) {
+				cpus.push_back(cpu);
+			}
+		} catch (...) {} // Skips anything that isn't a CPU or range of CPUs (eg. the trailing newline)
+		position = end + 1;
+	}
+	return cpus;
+}
+
+Topology::Topology() {
+	cpu_set_t allowedCpus;
+	CPU_ZERO(&allowedCpus);
+	bool hasAffinity = sched_getaffinity(0, sizeof(allowedCpus), &allowedCpus) == 0;
+	auto isAllowed = [&](int cpu) {
+		return cpu >= 0 && cpu < CPU_SETSIZE && (!hasAffinity || CPU_ISSET(cpu, &allowedCpus));
+	};
+
+	DIR* directory = opendir(nodeDirectory);
+	if (directory != nullptr) {
+		while (dirent* entry = readdir(directory)) {
+			string name = entry->d_name;
+			if (name.compare(0, 4, "node") != 0 || name.size() == 4
+				|| name.find_first_not_of("0123456789", 4) != string::npos) continue;
+
+			ifstream cpuListFile(string(nodeDirectory) + "/" + name + "/cpulist");
+			string cpuList;
+			getline(cpuListFile, cpuList);
+			NumaNode node;
+			node.id = stoi(name.substr(4));
+			for (int cpu : parseCpuList(cpuList)) {
+				if (isAllowed(cpu)) node.cpus.push_back(cpu);
+			}
+			if (!node.cpus.empty()) nodes.push_back(node);
+		}
+		closedir(directory);
+	}
+	sort(nodes.begin(), nodes.end(), [](const NumaNode& a, const NumaNode& b) { return a.id < b.id; });
+
+	if (nodes.empty()) {
+		NumaNode node;
+		node.id = 0;
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+			if (hasAffinity ? CPU_ISSET(cpu, &allowedCpus) : cpu == 0) node.cpus.push_back(cpu);
+		}
+		nodes.push_back(node);
+	}
+}
+
+const vector<NumaNode>& Topology::getNodes() {
+	return nodes;
+}
+
+void Topology::placeThreads(int threadCount, vector<int>& cpus, vector<int>& nodeIndices) {
+	// Orders the CPUs by their index within their node, then by node
+	size_t maxNodeCpuCount = 0;
+	for (NumaNode& node : nodes) {
+		maxNodeCpuCount = max(maxNodeCpuCount, node.cpus.size());
+	}
+	vector<pair<int, int>> order; // CPU and node index
+	for (size_t i = 0; i < maxNodeCpuCount; ++i) {
+		for (size_t node = 0; node < nodes.size(); ++node) {
+			if (i < nodes[node].cpus.size()) {
+				order.emplace_back(nodes[node].cpus[i], node);
+			}
+		}
+	}
+
+	cpus.clear();
+	nodeIndices.clear();
+	for (int thread = 0; thread < threadCount; ++thread) {
+		cpus.push_back(order[thread % order.size()].first);
+		nodeIndices.push_back(order[thread % order.size()].second);
+	}
+}
+
+bool Topology::pinCurrentThread(int cpu) {
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(cpu, &cpuSet);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+}
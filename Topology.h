@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+
+using std::vector;
+
+struct NumaNode {
+	int id;
+	vector<int> cpus; // CPUs of the node this process may run on
+};
+
+/*
+* NUMA layout of the CPUs this process may run on, read from the Linux topology under /sys/devices/system/node. Systems
+* without it (or without NUMA) are treated as a single node holding every CPU
+*/
+class Topology {
+	vector<NumaNode> nodes;
+
+public:
+	Topology();
+
+	const vector<NumaNode>& getNodes();
+
+	// Spreads threadCount threads over the CPUs, taking a CPU from each node in turn (so that fewer threads than CPUs
+	// still use every node's memory bandwidth) and wrapping around once every CPU is used. Gives the CPU and the index
+	// of the node (within getNodes()) of each thread
+	void placeThreads(int threadCount, vector<int>& cpus, vector<int>& nodeIndices);
+
+	// Restricts the calling thread to the CPU, returning false if it couldn't be
+	static bool pinCurrentThread(int cpu);
+};
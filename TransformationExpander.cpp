@@ -0,0 +1,99 @@
+#include "TransformationExpander.h"
+#include "Generator.h"
+
+using namespace std;
+
+// Identities allowed in flight per expander thread (enough to keep every thread busy while the writer catches up)
+const size_t inFlightPerThread = 4;
+
+template <typename Cell>
+TransformationExpander<Cell>::TransformationExpander(Generator<Cell>& _generator, OutputWriter& _output, 
+	unsigned threadCount)
+	: generator(_generator), output(_output) {
+	maxInFlight = threadCount * inFlightPerThread;
+	for (unsigned i = 0; i < threadCount; ++i) {
+		workers.emplace_back([this]() { work(); });
+	}
+}
+
+template <typename Cell>
+TransformationExpander<Cell>::~TransformationExpander() {
+	finish();
+}
+
+template <typename Cell>
+void TransformationExpander<Cell>::submit(vector<Cell>& set) {
+	unique_lock<mutex> lock(stateMutex);
+	spaceAvailable.wait(lock, [this]() { return submittedCount - writtenCount < maxInFlight; });
+	queue.emplace_back(submittedCount++, set);
+	workAvailable.notify_one();
+}
+
+template <typename Cell>
+void TransformationExpander<Cell>::finish() {
+	{
+		unique_lock<mutex> lock(stateMutex);
+		spaceAvailable.wait(lock, [this]() { return writtenCount == submittedCount; });
+		stopping = true;
+	}
+	workAvailable.notify_all();
+	for (thread& worker : workers) {
+		worker.join();
+	}
+	workers.clear();
+	output.flush();
+}
+
+template <typename Cell>
+unsigned long TransformationExpander<Cell>::getPrintedCubeCount() {
+	lock_guard<mutex> lock(stateMutex);
+	return printedCubeCount;
+}
+
+template <typename Cell>
+void TransformationExpander<Cell>::work() {
+	// Each thread compiles any transformations beyond those held by the generator into its own table
+	vector<int> scratchTable(generator.setSize);
+	unique_lock<mutex> lock(stateMutex);
+	while (true) {
+		workAvailable.wait(lock, [this]() { return !queue.empty() || stopping; });
+		if (queue.empty()) return;
+
+		unsigned long number = queue.front().first;
+		vector<Cell> set = move(queue.front().second);
+		queue.pop_front();
+		lock.unlock();
+
+		string buffer;
+		buffer.reserve(generator.transformationCount * generator.maxCubeTextLength);
+		unsigned long printedCount = generator.printTransformations(set, buffer, scratchTable);
+
+		lock.lock();
+		printedCubeCount += printedCount;
+		expanded.emplace(number, move(buffer));
+		writeReady(lock);
+	}
+}
+
+template <typename Cell>
+void TransformationExpander<Cell>::writeReady(unique_lock<mutex>& lock) {
+	// Only one thread writes at a time; any buffers finished while it writes are picked up by its next pass
+	if (writing) return;
+
+	writing = true;
+	auto iter = expanded.find(writtenCount);
+	while (iter != expanded.end()) {
+		string buffer = move(iter->second);
+		expanded.erase(iter);
+		lock.unlock();
+		output.write(buffer);
+		lock.lock();
+		++writtenCount;
+		spaceAvailable.notify_all();
+		iter = expanded.find(writtenCount);
+	}
+	writing = false;
+}
+
+template class TransformationExpander<uint8_t>;
+template class TransformationExpander<uint16_t>;
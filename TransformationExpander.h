@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using std::vector;
+using std::string;
+using std::map;
+using std::deque;
+using std::thread;
+using std::mutex;
+using std::condition_variable;
+
+template <typename Cell> class Generator;
+class OutputWriter;
+
+/*
+* Pipeline stage that prints every transformation of each identity (PrintOption::ALL) on a pool of expander threads, so
+* that the search only has to hand identities over rather than wait for their expansion.
+*
+* Identities are numbered as they are submitted, and each is expanded into its own buffer in the order
+* Generator::printTransformations() produces. Buffers are written out strictly in submission order, so the output is
+* identical to printing every transformation on the search thread. At most maxInFlight identities are queued, being
+* expanded or waiting to be written at once, beyond which submit() blocks
+*/
+template <typename Cell>
+class TransformationExpander {
+	Generator<Cell>& generator;
+	OutputWriter& output;
+	size_t maxInFlight;
+
+	mutex stateMutex;
+	condition_variable workAvailable; // Signalled when an identity is queued, or the expander is stopping
+	condition_variable spaceAvailable; // Signalled when an identity has been written
+	deque<std::pair<unsigned long, vector<Cell>>> queue; // Identities waiting to be expanded, by submission number
+	map<unsigned long, string> expanded; // Expanded identities waiting for those before them to be written
+	unsigned long submittedCount = 0;
+	unsigned long writtenCount = 0;
+	unsigned long printedCubeCount = 0; // Transformations printed (fewer than all of them when constrained)
+	bool writing = false; // Whether a thread is currently writing buffers out
+	bool stopping = false;
+
+	vector<thread> workers;
+
+	void work();
+
+	// Writes out every expanded buffer that is next in order. Called with the lock held (which is released while
+	// writing)
+	void writeReady(std::unique_lock<mutex>& lock);
+
+public:
+	TransformationExpander(Generator<Cell>& generator, OutputWriter& output, unsigned threadCount);
+	~TransformationExpander();
+
+	// Queues the identity held by set for expansion
+	void submit(vector<Cell>& set);
+
+	// Waits for every submitted identity to be written, and stops the expander threads
+	void finish();
+
+	unsigned long getPrintedCubeCount();
+};
@@ -0,0 +1,44 @@
+#include "TranspositionTable.h"
+
+using namespace std;
+
+void TranspositionTable::resize(size_t bytes) {
+	size_t bucketCount = 1;
+	while (bucketCount * 2 * sizeof(Bucket) <= bytes) {
+		bucketCount *= 2;
+	}
+	if (bytes < sizeof(Bucket)) {
+		bucketCount = 0;
+	}
+	buckets.assign(bucketCount, Bucket());
+	bucketMask = bucketCount == 0 ? 0 : bucketCount - 1;
+}
+
+bool TranspositionTable::isEnabled() {
+	return !buckets.empty();
+}
+
+bool TranspositionTable::find(const TranspositionKey& key, unsigned long& count) {
+	Bucket& bucket = buckets[key.hash1 & bucketMask];
+	for (TranspositionEntry& entry : bucket.entries) {
+		if (entry.work != 0 && entry.key.hash1 == key.hash1 && entry.key.hash2 == key.hash2) {
+			count = entry.count;
+			return true;
+		}
+	}
+	return false;
+}
+
+void TranspositionTable::store(const TranspositionKey& key, unsigned long count, unsigned long work) {
+	Bucket& bucket = buckets[key.hash1 & bucketMask];
+	TranspositionEntry entry = { key, count, work == 0 ? 1 : work };
+	if (bucket.entries[0].work <= entry.work) {
+		// Displaced from the first entry into the second, unless it is the same state
+		if (bucket.entries[0].key.hash1 != key.hash1 || bucket.entries[0].key.hash2 != key.hash2) {
+			bucket.entries[1] = bucket.entries[0];
+		}
+		bucket.entries[0] = entry;
+	} else {
+		bucket.entries[1] = entry;
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+using std::vector;
+
+// 128 bit fingerprint of a search state
+struct TranspositionKey {
+	uint64_t hash1;
+	uint64_t hash2;
+};
+
+struct TranspositionEntry {
+	TranspositionKey key;
+	uint64_t count; // Cube identities found below the state
+	uint64_t work; // Nodes it took to find them, or 0 for an empty entry
+};
+
+/*
+* Fixed size table of the cube identity counts found below search states, so that count-only searches can skip
+* subtrees they have already counted. States are identified by a 128 bit fingerprint (see Generator::
+* getTranspositionKey()), and collisions are ignored.
+*
+* Entries are held in cache line sized buckets of two. When a bucket is full, the first entry keeps whichever state
+* took the most work to count, and the second always takes the newest state, so that expensive subtrees are kept
+* while cheap ones still get a chance to be reused
+*/
+class TranspositionTable {
+	struct alignas(64) Bucket {
+		TranspositionEntry entries[2];
+	};
+
+	vector<Bucket> buckets;
+	size_t bucketMask = 0;
+
+public:
+	// Allocates a table of at most the given size (rounded down to a power of two buckets), or frees it if too small
+	// to hold a single bucket
+	void resize(size_t bytes);
+
+	bool isEnabled();
+
+	// Looks up the count stored for the key, returning false if there is none
+	bool find(const TranspositionKey& key, unsigned long& count);
+
+	void store(const TranspositionKey& key, unsigned long count, unsigned long work);
+};
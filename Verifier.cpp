@@ -0,0 +1,294 @@
+#include "Verifier.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <math.h>
+#include <queue>
+#include <tuple>
+#include <unistd.h>
+
+using namespace std;
+
+// Most run files merged at once (intermediate merge passes keep the number of open files below this)
+const int maxRunFanIn = 256;
+
+// Mixes value into hash (splitmix64 finaliser)
+inline uint64_t mixHash(uint64_t hash, uint64_t value) {
+	hash += value + 0x9e3779b97f4a7c15;
+	hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+	hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+	return hash ^ (hash >> 31);
+}
+
+inline uint64_t hashCube(vector<int>& cube, uint64_t seed) {
+	uint64_t hash = seed;
+	for (int value : cube) {
+		hash = mixHash(hash, value);
+	}
+	return hash;
+}
+
+bool CubeRecord::operator<(const CubeRecord& other) const {
+	return tie(identityHashes[0], identityHashes[1], cubeHash)
+		< tie(other.identityHashes[0], other.identityHashes[1], other.cubeHash);
+}
+
+bool CubeRecord::operator==(const CubeRecord& other) const {
+	return isSameIdentity(other) && cubeHash == other.cubeHash;
+}
+
+bool CubeRecord::isSameIdentity(const CubeRecord& other) const {
+	return identityHashes[0] == other.identityHashes[0] && identityHashes[1] == other.identityHashes[1];
+}
+
+Verifier::Verifier(int _sideLength, int _dimensionality, size_t _memoryLimit) {
+	sideLength = _sideLength;
+	dimensionality = _dimensionality;
+	memoryLimit = _memoryLimit;
+	setSize = pow(sideLength, dimensionality);
+	originalSum = (setSize + 1) * sideLength / 2;
+	for (int i = 0; i < dimensionality; ++i) {
+		dimensionScales.push_back(pow(sideLength, i));
+	}
+	records.reserve(max(memoryLimit / sizeof(CubeRecord), size_t(1)));
+	runDirectory = (filesystem::temp_directory_path() / ("magicHyperCubeVerify" + to_string(getpid()))).string();
+}
+
+Verifier::~Verifier() {
+	if (!runPaths.empty()) {
+		filesystem::remove_all(runDirectory);
+	}
+}
+
+bool Verifier::readFile(const string& path) {
+	ifstream ifs(path);
+	if (!ifs) return false;
+
+	vector<int> cube(setSize);
+	int count = 0;
+	while (ifs >> cube[count]) {
+		if (++count == setSize) {
+			addCube(cube);
+			count = 0;
+		}
+	}
+	return count == 0 && ifs.eof();
+}
+
+bool Verifier::isValid(vector<int>& cube) {
+	vector<bool> seen(setSize + 1, false);
+	for (int value : cube) {
+		if (value < 1 || value > setSize || seen[value]) return false;
+		seen[value] = true;
+	}
+
+	// Every line starts at a cell whose coordinate along the line's axis is 0
+	for (int axis = 0; axis < dimensionality; ++axis) {
+		for (int i = 0; i < setSize; ++i) {
+			if ((i / dimensionScales[axis]) % sideLength != 0) continue;
+
+			int sum = 0;
+			for (int j = 0; j < sideLength; ++j) {
+				sum += cube[i + dimensionScales[axis] * j];
+			}
+			if (sum != originalSum) return false;
+		}
+	}
+	return true;
+}
+
+void Verifier::canonicalise(vector<int>& cube, vector<int>& canonicalCube) {
+	int originIndex = find(cube.begin(), cube.end(), 1) - cube.begin();
+
+	// For each axis, the coordinates along the line through the origin cell, ordered by value (origin first)
+	vector<vector<int>> axisCoords(dimensionality);
+	for (int axis = 0; axis < dimensionality; ++axis) {
+		int scale = dimensionScales[axis];
+		int originCoord = (originIndex / scale) % sideLength;
+		int lineStart = originIndex - originCoord * scale;
+		vector<int>& coords = axisCoords[axis];
+		for (int coord = 0; coord < sideLength; ++coord) {
+			coords.push_back(coord);
+		}
+		swap(coords[0], coords[originCoord]);
+		sort(coords.begin() + 1, coords.end(), [&](int a, int b) {
+			return cube[lineStart + a * scale] < cube[lineStart + b * scale];
+		});
+	}
+
+	// Axes are ordered by the value following the origin along them
+	vector<int> axes;
+	for (int axis = 0; axis < dimensionality; ++axis) {
+		axes.push_back(axis);
+	}
+	if (sideLength > 1) {
+		sort(axes.begin(), axes.end(), [&](int a, int b) {
+			int aIndex = originIndex + (axisCoords[a][1] - axisCoords[a][0]) * dimensionScales[a];
+			int bIndex = originIndex + (axisCoords[b][1] - axisCoords[b][0]) * dimensionScales[b];
+			return cube[aIndex] < cube[bIndex];
+		});
+	}
+
+	// Canonical axis i at coordinate c maps onto original axis axes[i] at coordinate axisCoords[axes[i]][c]
+	for (int i = 0; i < setSize; ++i) {
+		int index = 0;
+		for (int axis = 0; axis < dimensionality; ++axis) {
+			int coord = (i / dimensionScales[axis]) % sideLength;
+			index += axisCoords[axes[axis]][coord] * dimensionScales[axes[axis]];
+		}
+		canonicalCube[i] = cube[index];
+	}
+}
+
+void Verifier::addCube(vector<int>& cube) {
+	++cubeCount;
+	if (!isValid(cube)) {
+		++invalidCubeCount;
+		return;
+	}
+
+	vector<int> canonicalCube(setSize);
+	canonicalise(cube, canonicalCube);
+	CubeRecord record;
+	record.identityHashes[0] = hashCube(canonicalCube, 0);
+	record.identityHashes[1] = hashCube(canonicalCube, 0x2545f4914f6cdd1d);
+	record.cubeHash = hashCube(cube, 0);
+	records.push_back(record);
+	if (records.size() * sizeof(CubeRecord) >= memoryLimit) {
+		writeRun();
+	}
+}
+
+void Verifier::writeRun() {
+	if (runPaths.empty()) {
+		filesystem::create_directories(runDirectory);
+	}
+	sort(records.begin(), records.end());
+	string path = getRunPath(runCount++);
+	ofstream ofs(path, ios::binary);
+	ofs.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(CubeRecord));
+	runPaths.push_back(path);
+	records.clear();
+}
+
+void Verifier::mergeRuns(vector<string>& inputPaths, function<void(CubeRecord&)> consume) {
+	vector<ifstream> inputs;
+	for (string& path : inputPaths) {
+		inputs.emplace_back(path, ios::binary);
+	}
+
+	// Heap of the current record of each input, smallest first
+	typedef pair<CubeRecord, int> Entry;
+	auto isGreater = [](const Entry& a, const Entry& b) { return b.first < a.first; };
+	priority_queue<Entry, vector<Entry>, decltype(isGreater)> heap(isGreater);
+	auto readRecord = [&](int input) {
+		CubeRecord record;
+		if (inputs[input].read(reinterpret_cast<char*>(&record), sizeof(record))) {
+			heap.push({ record, input });
+		}
+	};
+	for (int input = 0; input < int(inputs.size()); ++input) {
+		readRecord(input);
+	}
+	while (!heap.empty()) {
+		Entry entry = heap.top();
+		heap.pop();
+		consume(entry.first);
+		readRecord(entry.second);
+	}
+}
+
+void Verifier::finish(unsigned long cubesPerIdentity) {
+	distinctCubeCount = 0;
+	identityCount = 0;
+	incompleteIdentityCount = 0;
+
+	bool hasPrevious = false;
+	CubeRecord previous;
+	unsigned long identityCubeCount = 0;
+	auto consume = [&](CubeRecord& record) {
+		if (hasPrevious && record == previous) return;
+
+		if (!hasPrevious || !record.isSameIdentity(previous)) {
+			if (hasPrevious && identityCubeCount != cubesPerIdentity) {
+				++incompleteIdentityCount;
+			}
+			++identityCount;
+			identityCubeCount = 0;
+		}
+		++distinctCubeCount;
+		++identityCubeCount;
+		previous = record;
+		hasPrevious = true;
+	};
+
+	if (runPaths.empty()) {
+		// Everything fitted in memory
+		sort(records.begin(), records.end());
+		for (CubeRecord& record : records) {
+			consume(record);
+		}
+	} else {
+		if (!records.empty()) {
+			writeRun();
+		}
+
+		// Merges groups of runs into larger runs until they can all be merged at once
+		while (runPaths.size() > maxRunFanIn) {
+			cout << "Merging " << runPaths.size() << " runs..." << endl;
+			vector<string> mergedPaths;
+			for (size_t i = 0; i < runPaths.size(); i += maxRunFanIn) {
+				vector<string> groupPaths(runPaths.begin() + i, runPaths.begin() + min<size_t>(i + maxRunFanIn,
+					runPaths.size()));
+				string path = getRunPath(runCount++);
+				ofstream ofs(path, ios::binary);
+				mergeRuns(groupPaths, [&ofs](CubeRecord& record) {
+					ofs.write(reinterpret_cast<const char*>(&record), sizeof(record));
+				});
+				for (string& groupPath : groupPaths) {
+					filesystem::remove(groupPath);
+				}
+				mergedPaths.push_back(path);
+			}
+			runPaths = mergedPaths;
+		}
+		mergeRuns(runPaths, consume);
+	}
+	if (hasPrevious && identityCubeCount != cubesPerIdentity) {
+		++incompleteIdentityCount;
+	}
+}
+
+unsigned long Verifier::getCubeCount() {
+	return cubeCount;
+}
+
+unsigned long Verifier::getInvalidCubeCount() {
+	return invalidCubeCount;
+}
+
+unsigned long Verifier::getDistinctCubeCount() {
+	return distinctCubeCount;
+}
+
+unsigned long Verifier::getIdentityCount() {
+	return identityCount;
+}
+
+unsigned long Verifier::getIncompleteIdentityCount() {
+	return incompleteIdentityCount;
+}
+
+unsigned long Verifier::getTransformationCount() {
+	unsigned long sideLengthFact = 1;
+	for (int i = 2; i <= sideLength; ++i) sideLengthFact *= i;
+	unsigned long count = 1;
+	for (int i = 0; i < dimensionality; ++i) count *= sideLengthFact;
+	for (int i = 2; i <= dimensionality; ++i) count *= i;
+	return count;
+}
+
+string Verifier::getRunPath(int run) {
+	return runDirectory + "/run" + to_string(run) + ".bin";
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <functional>
+
+using std::vector;
+using std::string;
+using std::function;
+
+// A single cube read from an output file, reduced to the hash of its canonical identity and the hash of the cube itself
+struct CubeRecord {
+	uint64_t identityHashes[2];
+	uint64_t cubeHash;
+
+	bool operator<(const CubeRecord& other) const;
+	bool operator==(const CubeRecord& other) const;
+	bool isSameIdentity(const CubeRecord& other) const;
+};
+
+/*
+* Out-of-core verifier for generator output files. Every cube read is reduced to its canonical identity under the
+* transformation group that Generator::printTransformations() enumerates (every intra-axis permutation of every axis,
+* and every inter-axis permutation), and recorded as a pair of hashes. Records are sorted in memoryLimit sized runs that
+* are written to disk, and the runs are then merged, so that the files read may be far larger than memory.
+*
+* The canonical identity of a cube is the lexicographically smallest cube within its transformation orbit. As the
+* values of a cube are distinct, it is found directly: the cell holding 1 is moved to the origin, the other cells of
+* each axis's line through the origin are sorted ascending, and the axes are ordered by the smallest such value
+*/
+class Verifier {
+	int sideLength;
+	int dimensionality;
+	int setSize;
+	int originalSum;
+	vector<int> dimensionScales; // Set of values of sidelength^d where d -> [0, dimensionality - 1]
+	size_t memoryLimit; // Approximate number of bytes the in-memory record buffer is allowed to occupy
+
+	vector<CubeRecord> records;
+	vector<string> runPaths;
+	int runCount = 0; // Number of run files created so far (used to name the next one)
+	string runDirectory;
+
+	unsigned long cubeCount = 0;
+	unsigned long invalidCubeCount = 0;
+	unsigned long distinctCubeCount = 0;
+	unsigned long identityCount = 0;
+	unsigned long incompleteIdentityCount = 0;
+
+	// Checks that the cube holds every value in [1, setSize] exactly once, and that all of its lines add up correctly
+	bool isValid(vector<int>& cube);
+
+	// Writes the transformation of the cube with the smallest value ordering into canonicalCube
+	void canonicalise(vector<int>& cube, vector<int>& canonicalCube);
+
+	void addCube(vector<int>& cube);
+
+	// Sorts the record buffer and writes it to a new run file
+	void writeRun();
+
+	// Merges the run files, passing every record to consume in sorted order
+	void mergeRuns(vector<string>& inputPaths, function<void(CubeRecord&)> consume);
+
+	string getRunPath(int run);
+
+public:
+	Verifier(int sideLength, int dimensionality, size_t memoryLimit);
+	~Verifier();
+
+	// Reads every cube from the output file (a sequence of setSize whitespace separated values per cube, in the format
+	// Generator::printCube() writes). Returns false if the file can't be opened or ends partway through a cube
+	bool readFile(const string& path);
+
+	// Merges everything read so far, counting distinct cubes and identities. Identities made up of anything other than
+	// cubesPerIdentity distinct cubes are counted as incomplete
+	void finish(unsigned long cubesPerIdentity);
+
+	unsigned long getCubeCount();
+	unsigned long getInvalidCubeCount();
+	unsigned long getDistinctCubeCount();
+	unsigned long getIdentityCount();
+	unsigned long getIncompleteIdentityCount();
+
+	// Number of transformations of each identity (sideLength!^dimensionality * dimensionality!)
+	unsigned long getTransformationCount();
+};
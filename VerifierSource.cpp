@@ -0,0 +1,80 @@
+#include <iostream>
+#include <string>
+#include <charconv>
+#include "Verifier.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::from_chars;
+using std::errc;
+
+// Parses the whole of the text as an integer of the value's type, returning false if it isn't one
+template <typename Integer> bool parseInteger(const string& text, Integer& value) {
+	auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+	return error == errc() && end == text.data() + text.size();
+}
+
+int main(int argc, char* argv[]) {
+	int sideLength = 0;
+	int dimensionality = 0;
+	bool valid = argc > 3 && parseInteger(argv[1], sideLength) && sideLength > 0 
+		&& parseInteger(argv[2], dimensionality) && dimensionality > 0;
+	bool allTransformations = false;
+	unsigned long expectedIdentityCount = 0;
+	bool hasExpectedIdentityCount = false;
+	size_t memoryLimitMb = 1024;
+	vector<string> paths;
+	for (int i = 3; i < argc && valid; ++i) {
+		string arg = argv[i];
+		if (arg == "--all") {
+			allTransformations = true;
+		} else if (arg == "--expected" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], expectedIdentityCount);
+			hasExpectedIdentityCount = true;
+		} else if (arg == "--memory" && i + 1 < argc) {
+			valid = parseInteger(argv[++i], memoryLimitMb) && memoryLimitMb > 0;
+		} else {
+			paths.push_back(arg);
+		}
+	}
+	if (!valid || paths.empty()) {
+		cout << "Usage: " << argv[0] << " sideLength dimensionality [--all] [--expected identityCount] "
+			<< "[--memory megabytes] file..." << endl;
+		return 1;
+	}
+
+	Verifier verifier(sideLength, dimensionality, memoryLimitMb << 20);
+	for (string& path : paths) {
+		cout << "Reading " << path << "..." << endl;
+		if (!verifier.readFile(path)) {
+			cout << "Couldn't read " << path << " (missing, or ends partway through a cube)" << endl;
+			return 1;
+		}
+	}
+
+	// Output files either hold every transformation of each identity, or just the identity
+	unsigned long cubesPerIdentity = allTransformations ? verifier.getTransformationCount() : 1;
+	verifier.finish(cubesPerIdentity);
+
+	unsigned long duplicateCubeCount = verifier.getCubeCount() - verifier.getInvalidCubeCount() 
+		- verifier.getDistinctCubeCount();
+	cout << "Cubes: " << verifier.getCubeCount() << endl;
+	cout << "Invalid cubes: " << verifier.getInvalidCubeCount() << endl;
+	cout << "Duplicate cubes: " << duplicateCubeCount << endl;
+	cout << "Cube identities: " << verifier.getIdentityCount() << endl;
+	cout << "Incomplete identities (not made up of " << cubesPerIdentity << " distinct cubes): " 
+		<< verifier.getIncompleteIdentityCount() << endl;
+	bool passed = verifier.getInvalidCubeCount() == 0 && duplicateCubeCount == 0 
+		&& verifier.getIncompleteIdentityCount() == 0;
+	if (hasExpectedIdentityCount) {
+		unsigned long identityCount = verifier.getIdentityCount();
+		cout << "Missing identities: " << (identityCount < expectedIdentityCount ? expectedIdentityCount - identityCount : 0) 
+			<< endl;
+		cout << "Unexpected identities: " << (identityCount > expectedIdentityCount ? identityCount - expectedIdentityCount : 0) 
+			<< endl;
+		passed = passed && identityCount == expectedIdentityCount;
+	}
+	cout << (passed ? "Passed" : "Failed") << endl;
+	return passed ? 0 : 1;
+}